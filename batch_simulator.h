@@ -0,0 +1,535 @@
+/*
+ * File:   batch_simulator.h
+ *
+ * Lockstep simulator: many independent simple_policy games advanced one
+ * decision at a time together, with their state stored as structure of
+ * arrays so the per-decision checks run as SIMD kernels over many games.
+ */
+
+#ifndef BATCH_SIMULATOR_H
+#define BATCH_SIMULATOR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "card.h"
+#include "card_piles.h"
+#include "game_engine.h"
+#include "rng.h"
+#include "thread_pool.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BATCH_X86 1
+#endif
+
+#define BATCH_LANES 1024 // games in flight per simulator
+#define LANE_BLOCK 64 // lanes are allocated in whole blocks, one bit each in a 64 bit word
+
+enum SIMD_LEVEL {
+    simd_scalar, simd_avx2, simd_avx512
+};
+
+// Function to get the widest SIMD_LEVEL the running CPU supports
+
+inline SIMD_LEVEL detect_simd() {
+#ifdef BATCH_X86
+    if (__builtin_cpu_supports("avx512f")) {
+        return simd_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return simd_avx2;
+    }
+#endif
+    return simd_scalar;
+}
+
+inline const char* simd_name(SIMD_LEVEL level) {
+    return level == simd_avx512 ? "avx512" : level == simd_avx2 ? "avx2" : "scalar";
+}
+
+/**
+ * Struct: LaneState
+ * Description:
+ * The state of every game of a BatchSimulator, one array entry per game
+ * (lane). Hands are stored per seat: entry seat * lanes + lane, so the
+ * current player's presence mask of every lane is one gather away. The
+ * counts of a hand (80 bytes) and the two piles (the CardPiles ring the
+ * engine uses) are kept per lane, as only the scalar part of a step reads
+ * them.
+ */
+struct LaneState {
+    int lanes;
+    int amount_players;
+    // one word per lane
+    std::vector<int32_t> active; // -1 while the lane plays a game, 0 once it ran out of games
+    std::vector<int32_t> top; // played_card, a wild carries the colour it named
+    std::vector<int32_t> seat; // whose turn it is
+    std::vector<int32_t> direction; // 0 clockwise, 1 counter clockwise
+    std::vector<int32_t> winner;
+    std::vector<int32_t> turn_count;
+    std::vector<uint8_t> force; // force_draw_bool: an action card was just played
+    std::vector<CardPiles> piles;
+    std::vector<Rng> rng;
+    // one entry per (seat, lane)
+    std::vector<uint64_t> present_lo; // codes 0-63 held
+    std::vector<uint64_t> present_hi; // codes 64-79 held
+    std::vector<int32_t> hand_size;
+    std::vector<uint8_t> counts; // CARD_CODES per (seat, lane)
+    // kernel outputs
+    std::vector<uint64_t> mask_lo; // playable cards of the player to move
+    std::vector<uint64_t> mask_hi;
+    std::vector<uint64_t> finished; // one bit per lane whose game just ended
+
+    LaneState() : lanes(0), amount_players(0) {
+    }
+
+    void resize(int lanes, int amount_players) {
+        this->lanes = lanes;
+        this->amount_players = amount_players;
+        active.assign(lanes, 0);
+        top.assign(lanes, 0);
+        seat.assign(lanes, 0);
+        direction.assign(lanes, 0);
+        winner.assign(lanes, -1);
+        turn_count.assign(lanes, 0);
+        force.assign(lanes, 0);
+        piles.assign(lanes, CardPiles());
+        rng.assign(lanes, Rng());
+        present_lo.assign(lanes * amount_players, 0);
+        present_hi.assign(lanes * amount_players, 0);
+        hand_size.assign(lanes * amount_players, 0);
+        counts.assign((size_t) lanes * amount_players * CARD_CODES, 0);
+        mask_lo.assign(lanes, 0);
+        mask_hi.assign(lanes, 0);
+        finished.assign(lanes / LANE_BLOCK, 0);
+    }
+};
+
+// Function to find the playable cards of the player to move in every lane: present & PLAYABLE[top]
+
+inline void playable_scalar(LaneState& s) {
+    for (int l = 0; l < s.lanes; l++) {
+        int hand = s.seat[l] * s.lanes + l;
+        const PlayableMask& mask = PLAYABLE[s.top[l]];
+        s.mask_lo[l] = s.present_lo[hand] & mask.bits[0];
+        s.mask_hi[l] = s.present_hi[hand] & mask.bits[1];
+    }
+}
+
+// Function to flag the active lanes whose game was won or ran into MAX_TURNS
+
+inline void finished_scalar(LaneState& s) {
+    for (int block = 0; block < s.lanes / LANE_BLOCK; block++) {
+        uint64_t bits = 0;
+        for (int i = 0; i < LANE_BLOCK; i++) {
+            int l = block * LANE_BLOCK + i;
+            bool done = s.active[l] != 0 && (s.winner[l] >= 0 || s.turn_count[l] >= MAX_TURNS);
+            bits |= (uint64_t) done << i;
+        }
+        s.finished[block] = bits;
+    }
+}
+
+#ifdef BATCH_X86
+
+__attribute__((target("avx2")))
+inline void playable_avx2(LaneState& s) {
+    const long long* table = reinterpret_cast<const long long*> (PLAYABLE.data());
+    const long long* lo = reinterpret_cast<const long long*> (s.present_lo.data());
+    const long long* hi = reinterpret_cast<const long long*> (s.present_hi.data());
+    __m128i lanes = _mm_set1_epi32(s.lanes);
+    __m128i offsets = _mm_setr_epi32(0, 1, 2, 3);
+    for (int l = 0; l < s.lanes; l += 4) {
+        __m128i seat = _mm_loadu_si128(reinterpret_cast<const __m128i*> (&s.seat[l]));
+        __m128i top2 = _mm_slli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*> (&s.top[l])), 1);
+        __m128i hand = _mm_add_epi32(_mm_mullo_epi32(seat, lanes), _mm_add_epi32(_mm_set1_epi32(l), offsets));
+        __m256i held_lo = _mm256_i32gather_epi64(lo, hand, 8);
+        __m256i held_hi = _mm256_i32gather_epi64(hi, hand, 8);
+        __m256i fits_lo = _mm256_i32gather_epi64(table, top2, 8);
+        __m256i fits_hi = _mm256_i32gather_epi64(table + 1, top2, 8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*> (&s.mask_lo[l]), _mm256_and_si256(held_lo, fits_lo));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*> (&s.mask_hi[l]), _mm256_and_si256(held_hi, fits_hi));
+    }
+}
+
+__attribute__((target("avx2")))
+inline void finished_avx2(LaneState& s) {
+    __m256i none = _mm256_set1_epi32(-1);
+    __m256i last_turn = _mm256_set1_epi32(MAX_TURNS - 1);
+    for (int block = 0; block < s.lanes / LANE_BLOCK; block++) {
+        uint64_t bits = 0;
+        for (int i = 0; i < LANE_BLOCK; i += 8) {
+            int l = block * LANE_BLOCK + i;
+            __m256i active = _mm256_loadu_si256(reinterpret_cast<const __m256i*> (&s.active[l]));
+            __m256i winner = _mm256_loadu_si256(reinterpret_cast<const __m256i*> (&s.winner[l]));
+            __m256i turns = _mm256_loadu_si256(reinterpret_cast<const __m256i*> (&s.turn_count[l]));
+            __m256i done = _mm256_or_si256(_mm256_cmpgt_epi32(winner, none), _mm256_cmpgt_epi32(turns, last_turn));
+            done = _mm256_and_si256(done, active);
+            bits |= (uint64_t) _mm256_movemask_ps(_mm256_castsi256_ps(done)) << i;
+        }
+        s.finished[block] = bits;
+    }
+}
+
+__attribute__((target("avx512f")))
+inline void playable_avx512(LaneState& s) {
+    const long long* table = reinterpret_cast<const long long*> (PLAYABLE.data());
+    const long long* lo = reinterpret_cast<const long long*> (s.present_lo.data());
+    const long long* hi = reinterpret_cast<const long long*> (s.present_hi.data());
+    __m256i lanes = _mm256_set1_epi32(s.lanes);
+    __m256i offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    // masked gathers with every lane on, the unmasked ones start from an undefined register
+    __m512i zero = _mm512_setzero_si512();
+    __mmask8 all = 0xFF;
+    for (int l = 0; l < s.lanes; l += 8) {
+        __m256i seat = _mm256_loadu_si256(reinterpret_cast<const __m256i*> (&s.seat[l]));
+        __m256i top2 = _mm256_slli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*> (&s.top[l])), 1);
+        __m256i hand = _mm256_add_epi32(_mm256_mullo_epi32(seat, lanes), _mm256_add_epi32(_mm256_set1_epi32(l), offsets));
+        __m512i held_lo = _mm512_mask_i32gather_epi64(zero, all, hand, lo, 8);
+        __m512i held_hi = _mm512_mask_i32gather_epi64(zero, all, hand, hi, 8);
+        __m512i fits_lo = _mm512_mask_i32gather_epi64(zero, all, top2, table, 8);
+        __m512i fits_hi = _mm512_mask_i32gather_epi64(zero, all, top2, table + 1, 8);
+        _mm512_storeu_si512(&s.mask_lo[l], _mm512_and_si512(held_lo, fits_lo));
+        _mm512_storeu_si512(&s.mask_hi[l], _mm512_and_si512(held_hi, fits_hi));
+    }
+}
+
+__attribute__((target("avx512f")))
+inline void finished_avx512(LaneState& s) {
+    __m512i none = _mm512_set1_epi32(-1);
+    __m512i last_turn = _mm512_set1_epi32(MAX_TURNS - 1);
+    __m512i zero = _mm512_setzero_si512();
+    for (int block = 0; block < s.lanes / LANE_BLOCK; block++) {
+        uint64_t bits = 0;
+        for (int i = 0; i < LANE_BLOCK; i += 16) {
+            int l = block * LANE_BLOCK + i;
+            __m512i active = _mm512_loadu_si512(&s.active[l]);
+            __m512i winner = _mm512_loadu_si512(&s.winner[l]);
+            __m512i turns = _mm512_loadu_si512(&s.turn_count[l]);
+            __mmask16 done = _mm512_cmpgt_epi32_mask(winner, none) | _mm512_cmpgt_epi32_mask(turns, last_turn);
+            done &= _mm512_cmpneq_epi32_mask(active, zero);
+            bits |= (uint64_t) done << i;
+        }
+        s.finished[block] = bits;
+    }
+}
+
+#endif
+
+/**
+ * Class: BatchSimulator
+ * Description:
+ * Plays games with simple_policy for every seat, like run_games, but keeps
+ * `lanes` games in flight and moves all of them one decision on per round.
+ * A round is two vector kernels and one scalar pass:
+ * - the playable kernel gathers the current player's presence mask and the
+ *   PLAYABLE row of the top card in every lane and ANDs them, which is
+ *   card::operator== for a whole hand in many games at once;
+ * - the scalar pass turns those masks into the simple_policy decision (first
+ *   coloured card, else a wild, else draw) and applies it, updating counts,
+ *   piles, seat and forced draws for that lane;
+ * - the finished kernel compares winners and turn counts across lanes and
+ *   returns a bit per lane whose game ended, so only those lanes are visited
+ *   to record the result and deal the next game.
+ *
+ * Every lane follows GameEngine's rules and consumes its random stream in the
+ * same order, so game i played here is the same game as game i of run_games
+ * with the same seed and the totals come out identical. The kernels exist for
+ * AVX-512, AVX2 and plain C++; the widest the CPU supports is chosen at run
+ * time unless a level is asked for.
+ *
+ * Functionality:
+ * - `run`: Plays games first .. first+count-1 of a seed and adds them to a result.
+ * - `get_level`: Gets the SIMD level in use.
+ */
+class BatchSimulator {
+public:
+
+    BatchSimulator(int lanes = BATCH_LANES, SIMD_LEVEL level = detect_simd()) : level(level) {
+        this->lanes = (std::max(lanes, 1) + LANE_BLOCK - 1) / LANE_BLOCK * LANE_BLOCK;
+        if (level > detect_simd()) {
+            this->level = detect_simd();
+        }
+    }
+
+    SIMD_LEVEL get_level() const {
+        return level;
+    }
+
+    // Function to play games first .. first+count-1, game i seeded with game_seed(seed, i), into result
+
+    void run(long long first, long long count, uint64_t seed, int amount_players, SimulationResult& result) {
+        if (state.lanes != lanes || state.amount_players != amount_players) {
+            state.resize(lanes, amount_players);
+        }
+        this->seed = seed;
+        next_game = first;
+        last_game = first + count;
+        for (int l = 0; l < lanes; l++) {
+            start_next(l);
+        }
+
+        while (true) {
+            playable();
+            bool any = false;
+            for (int l = 0; l < lanes; l++) {
+                if (state.active[l] != 0) {
+                    apply(l);
+                    any = true;
+                }
+            }
+            if (!any) {
+                break;
+            }
+            finished();
+            for (int block = 0; block < lanes / LANE_BLOCK; block++) {
+                for (uint64_t bits = state.finished[block]; bits != 0; bits &= bits - 1) {
+                    int l = block * LANE_BLOCK + __builtin_ctzll(bits);
+                    result.games++;
+                    result.total_turns += state.turn_count[l];
+                    if (state.winner[l] >= 0) {
+                        result.wins[state.winner[l]]++;
+                    } else {
+                        result.unfinished++;
+                    }
+                    start_next(l);
+                }
+            }
+        }
+    }
+
+private:
+    int lanes;
+    SIMD_LEVEL level;
+    LaneState state;
+    uint64_t seed;
+    long long next_game;
+    long long last_game;
+
+    void playable() {
+#ifdef BATCH_X86
+        if (level == simd_avx512) {
+            playable_avx512(state);
+            return;
+        }
+        if (level == simd_avx2) {
+            playable_avx2(state);
+            return;
+        }
+#endif
+        playable_scalar(state);
+    }
+
+    void finished() {
+#ifdef BATCH_X86
+        if (level == simd_avx512) {
+            finished_avx512(state);
+            return;
+        }
+        if (level == simd_avx2) {
+            finished_avx2(state);
+            return;
+        }
+#endif
+        finished_scalar(state);
+    }
+
+    // Function to deal the next game into lane l, as GameEngine::new_game does, or park the lane
+
+    void start_next(int l) {
+        LaneState& s = state;
+        if (next_game >= last_game) {
+            s.active[l] = 0;
+            s.seat[l] = 0;
+            s.top[l] = 0;
+            s.winner[l] = -1;
+            s.turn_count[l] = 0;
+            return;
+        }
+        Rng& rng = s.rng[l];
+        rng.seed(game_seed(seed, next_game++));
+        for (int seat = 0; seat < s.amount_players; seat++) {
+            int hand = seat * lanes + l;
+            s.present_lo[hand] = 0;
+            s.present_hi[hand] = 0;
+            s.hand_size[hand] = 0;
+            std::memset(&s.counts[(size_t) hand * CARD_CODES], 0, CARD_CODES);
+        }
+
+        CardPiles& piles = s.piles[l];
+        piles.create();
+        piles.shuffle(rng);
+
+        int hand_size = GameEngine::starting_hand(s.amount_players);
+        for (int seat = 0; seat < s.amount_players; seat++) {
+            for (int k = 0; k < hand_size; k++) {
+                hand_add(l, seat, piles.draw().get_code());
+            }
+        }
+        card temp_card = piles.draw();
+        while (temp_card.color() == wild) {
+            piles.discard(temp_card);
+            temp_card = piles.draw();
+        }
+        piles.discard(temp_card);
+        s.top[l] = temp_card.get_code();
+
+        s.seat[l] = rng.bounded(s.amount_players);
+        s.direction[l] = 0;
+        s.force[l] = 0;
+        s.winner[l] = -1;
+        s.turn_count[l] = 0;
+        s.active[l] = -1;
+    }
+
+    void hand_add(int l, int seat, int code) {
+        int hand = seat * lanes + l;
+        state.counts[(size_t) hand * CARD_CODES + code]++;
+        (code < 64 ? state.present_lo[hand] : state.present_hi[hand]) |= 1ULL << (code & 63);
+        state.hand_size[hand]++;
+    }
+
+    void hand_remove(int l, int seat, int code) {
+        int hand = seat * lanes + l;
+        if (--state.counts[(size_t) hand * CARD_CODES + code] == 0) {
+            (code < 64 ? state.present_lo[hand] : state.present_hi[hand]) &= ~(1ULL << (code & 63));
+        }
+        state.hand_size[hand]--;
+    }
+
+    int next_seat(int l, int seat) const {
+        int n = state.amount_players;
+        return state.direction[l] == 0 ? (seat + 1 == n ? 0 : seat + 1) : (seat == 0 ? n - 1 : seat - 1);
+    }
+
+    // Function to put a card on the discard pile of lane l
+
+    void play(int l, int code) {
+        state.piles[l].discard(card(code & 15, static_cast<COLOR> (code >> 4)));
+        state.top[l] = code;
+        int number = code & 15;
+        if (number >= DRAW_TWO && number <= WILD_DRAW_FOUR) {
+            state.force[l] = 1;
+        }
+    }
+
+    bool draw(int l, int& code) {
+        CardPiles& piles = state.piles[l];
+        if (piles.is_main_empty()) {
+            piles.recycle(state.rng[l]);
+            if (piles.is_main_empty()) {
+                return false;
+            }
+        }
+        code = piles.draw().get_code();
+        return true;
+    }
+
+    void end_turn(int l) {
+        LaneState& s = state;
+        s.turn_count[l]++;
+        int number = s.top[l] & 15;
+        if (s.force[l] && number == SKIP) {
+            s.seat[l] = next_seat(l, next_seat(l, s.seat[l]));
+        } else if (s.force[l] && number == REVERSE) {
+            if (s.amount_players == 2) {
+                s.seat[l] = next_seat(l, next_seat(l, s.seat[l]));
+            } else {
+                s.direction[l] ^= 1;
+                s.seat[l] = next_seat(l, s.seat[l]);
+            }
+        } else {
+            s.seat[l] = next_seat(l, s.seat[l]);
+        }
+
+        if (s.piles[l].get_main_size() < RESHUFFLE_THRESHOLD) {
+            s.piles[l].recycle(s.rng[l]);
+        }
+
+        if (s.force[l]) {
+            int forced = number == DRAW_TWO ? 2 : number == WILD_DRAW_FOUR ? 4 : 0;
+            int code;
+            for (int i = 0; i < forced && draw(l, code); i++) {
+                hand_add(l, s.seat[l], code);
+            }
+            s.force[l] = 0;
+        }
+    }
+
+    // Function to make the simple_policy decision of lane l from its playable masks and apply it
+
+    void apply(int l) {
+        LaneState& s = state;
+        int seat = s.seat[l];
+        uint64_t mask_lo = s.mask_lo[l];
+        uint64_t mask_hi = s.mask_hi[l];
+        // codes 0-15 are the wild cards
+        uint64_t colored_lo = mask_lo & ~0xFFFFULL;
+        if (colored_lo != 0 || mask_hi != 0) {
+            int code = colored_lo != 0 ? __builtin_ctzll(colored_lo) : 64 + __builtin_ctzll(mask_hi);
+            hand_remove(l, seat, code);
+            play(l, code);
+        } else if (mask_lo != 0) {
+            int code = __builtin_ctzll(mask_lo);
+            const uint8_t* counts = &s.counts[(size_t) (seat * lanes + l) * CARD_CODES];
+            int best = red;
+            int best_count = -1;
+            for (int col = red; col <= yellow; col++) {
+                int held = 0;
+                for (int number = 0; number < 16; number++) {
+                    held += counts[col * 16 + number];
+                }
+                if (held > best_count) {
+                    best = col;
+                    best_count = held;
+                }
+            }
+            hand_remove(l, seat, code);
+            play(l, code);
+            s.top[l] = best * 16 + (code & 15);
+        } else {
+            int code;
+            if (draw(l, code)) {
+                const PlayableMask& fits = PLAYABLE[s.top[l]];
+                if (((fits.bits[code >> 6] >> (code & 63)) & 1) && (code >> 4) != wild) {
+                    play(l, code);
+                } else {
+                    hand_add(l, seat, code);
+                }
+            }
+            end_turn(l);
+            return;
+        }
+
+        if (s.hand_size[seat * lanes + l] == 0) {
+            s.winner[l] = seat;
+            s.turn_count[l]++;
+            return;
+        }
+        end_turn(l);
+    }
+};
+
+// Function to play n_games games on every worker of pool with one BatchSimulator each,
+// seeded like run_games, so the result is the same as run_games for any thread count
+
+inline SimulationResult run_games_batched(long long n_games, uint64_t seed, int amount_players, WorkStealingPool& pool, SIMD_LEVEL level = detect_simd()) {
+    std::vector<BatchSimulator> simulators(pool.get_threads(), BatchSimulator(BATCH_LANES, level));
+    std::vector<SimulationResult> results(pool.get_threads());
+    long long per_task = 16 * BATCH_LANES;
+    uint32_t n_tasks = (n_games + per_task - 1) / per_task;
+
+    pool.run(n_tasks, [&](int w, uint32_t task) {
+        long long first = (long long) task * per_task;
+        simulators[w].run(first, std::min(per_task, n_games - first), seed, amount_players, results[w]);
+    });
+
+    SimulationResult result;
+    for (const SimulationResult& worker_result : results) {
+        result.merge(worker_result);
+    }
+    return result;
+}
+
+#endif /* BATCH_SIMULATOR_H */
@@ -0,0 +1,273 @@
+/*
+ * File:   benchmark.cpp
+ *
+ * Micro benchmarks of the deck and hand operations and of the id maps, and
+ * macro benchmarks of whole headless games, reported as CSV or JSON and optionally compared
+ * against a stored baseline.
+ *
+ * usage: benchmark [--format csv|json] [--filter text] [--min-time seconds]
+ *                  [--baseline file] [--threshold fraction] [--save file]
+ *
+ * With --baseline the exit status is 1 when any benchmark is more than the
+ * threshold (default 0.15) slower than in the baseline. --save writes the
+ * results as a new baseline.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "batch_simulator.h"
+#include "benchmark.h"
+#include "card.h"
+#include "deck.h"
+#include "flat_map.h"
+#include "game_engine.h"
+#include "player.h"
+#include "rng.h"
+using namespace std;
+
+// Function to fill a deck with the 108 cards of MASTER_DECK in order
+
+void refill(deck& d) {
+    d.assign(MASTER_DECK.data(), DECK_SIZE);
+}
+
+void deck_benchmarks(BenchmarkSuite& suite) {
+    deck d;
+    Rng rng;
+    rng.seed(1);
+
+    suite.run("deck_create", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            d.assign(MASTER_DECK.data(), 0);
+            d.create();
+            do_not_optimize(d.at(0));
+        }
+    });
+    refill(d);
+    suite.run("deck_shuffle", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            d.shuffle(rng);
+            do_not_optimize(d.at(0));
+        }
+    });
+    suite.run("deck_quick_shuffle", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            d.quick_shuffle(rng);
+            do_not_optimize(d.at(0));
+        }
+    });
+    suite.run("deck_draw", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            if (d.isDeckEmpty()) {
+                refill(d);
+            }
+            do_not_optimize(d.draw());
+        }
+    });
+    suite.run("deck_draw_multiple_7", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            if (d.get_size() < 7) {
+                refill(d);
+            }
+            list<card> drawn = d.drawMultiple(7);
+            do_not_optimize(drawn.front());
+        }
+    });
+    // bottom inserts on a nearly full deck, drawing from the top keeps the size steady
+    d.assign(MASTER_DECK.data(), 100);
+    suite.run("deck_add_card_to_bottom", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            d.addCardToBottom(d.draw());
+            do_not_optimize(d.at(0));
+        }
+    });
+    suite.run("deck_draw_bottom", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            card temp_card = d.draw_bottom();
+            d.add_card(temp_card);
+            do_not_optimize(temp_card);
+        }
+    });
+    refill(d);
+    suite.run("deck_remove_card", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            card temp_card = MASTER_DECK[i % DECK_SIZE];
+            d.removeCard(temp_card);
+            d.add_card(temp_card);
+            do_not_optimize(d.at(0));
+        }
+    });
+}
+
+void player_benchmarks(BenchmarkSuite& suite) {
+    player hand;
+    for (int i = 0; i < STARTING_HAND; i++) {
+        hand.hand_add(MASTER_DECK[i * 13]);
+    }
+
+    suite.run("player_hand_add_remove", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            hand.hand_add(MASTER_DECK[i % DECK_SIZE]);
+            do_not_optimize(hand.hand_remove(i % hand.get_size()));
+        }
+    });
+    suite.run("player_peek", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            do_not_optimize(hand.peek(i % hand.get_size()));
+        }
+    });
+    suite.run("player_copy", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            player copy = hand;
+            do_not_optimize(copy);
+        }
+    });
+}
+
+// the value of an id that is in the map, through each map's own find
+
+uint64_t* find_value(FlatMap<uint64_t, uint64_t>& map, uint64_t id) {
+    return map.find(id);
+}
+
+uint64_t* find_value(unordered_map<uint64_t, uint64_t>& map, uint64_t id) {
+    return &map.find(id)->second;
+}
+
+// Function to time lookups of ids present in a map of `entries` ids, and an insert and erase of an id that is not,
+// for the map type Map. The ids are dense and handed out in order, like connection and table ids.
+
+template <class Map>
+void map_benchmark(BenchmarkSuite& suite, const string& name, uint64_t entries) {
+    Map map;
+    for (uint64_t id = 1; id <= entries; id++) {
+        map[id] = id;
+    }
+    // probe in an order the prefetcher cannot follow, a fresh id per probe would time the generator instead;
+    // 65536 probes touch more memory than the caches hold once the map is large
+    vector<uint64_t> probes(65536);
+    Rng rng;
+    rng.seed(1);
+    for (int i = 0; i < 65536; i++) {
+        probes[i] = 1 + rng.next() % entries;
+    }
+
+    suite.run(name + "_find_" + (entries >= 1000000 ? "1m" : to_string(entries)), [&](long long n) {
+        uint64_t sum = 0;
+        for (long long i = 0; i < n; i++) {
+            sum += *find_value(map, probes[i & 65535]);
+        }
+        do_not_optimize(sum);
+    });
+    suite.run(name + "_insert_erase_" + (entries >= 1000000 ? "1m" : to_string(entries)), [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            map[entries + 1] = i;
+            map.erase(entries + 1);
+        }
+        do_not_optimize(map.size());
+    });
+}
+
+void map_benchmarks(BenchmarkSuite& suite) {
+    for (uint64_t entries : {5ULL, 64ULL, 1000000ULL}) {
+        map_benchmark<FlatMap<uint64_t, uint64_t>>(suite, "flat_map", entries);
+        map_benchmark<unordered_map<uint64_t, uint64_t>>(suite, "unordered_map", entries);
+    }
+}
+
+// Function to time one full simple_policy game at amount_players players, per operation
+
+void game_benchmark(BenchmarkSuite& suite, const string& name, int amount_players) {
+    GameEngine engine;
+    SimulationResult result;
+    uint64_t game = 0;
+    suite.run(name, [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            play_game(engine, amount_players, game_seed(1, game++), result);
+        }
+    });
+    do_not_optimize(result.total_turns);
+}
+
+void game_benchmarks(BenchmarkSuite& suite) {
+    for (int amount_players = 2; amount_players <= 5; amount_players++) {
+        game_benchmark(suite, "game_" + to_string(amount_players) + "p", amount_players);
+    }
+    // ten hands of seven leave 37 cards to draw from, so the discard pile is recycled every few turns
+    game_benchmark(suite, "game_10p_reshuffle_heavy", 10);
+
+    BatchSimulator simulator;
+    SimulationResult result;
+    uint64_t first = 0;
+    suite.run("batch_game_4p", [&](long long n) {
+        simulator.run(first, n, 1, 4, result);
+        first += n;
+    });
+    do_not_optimize(result.total_turns);
+}
+
+int main(int argc, char** argv) {
+    string format = "csv";
+    string filter;
+    string baseline;
+    string save;
+    double min_time = 0.5;
+    double threshold = 0.15;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--format") {
+            format = argv[i + 1];
+        } else if (option == "--filter") {
+            filter = argv[i + 1];
+        } else if (option == "--min-time") {
+            min_time = atof(argv[i + 1]);
+        } else if (option == "--baseline") {
+            baseline = argv[i + 1];
+        } else if (option == "--threshold") {
+            threshold = atof(argv[i + 1]);
+        } else if (option == "--save") {
+            save = argv[i + 1];
+        } else {
+            cerr << "unknown option " << option << endl;
+            return 2;
+        }
+    }
+    if ((argc - 1) % 2 != 0 || (format != "csv" && format != "json") || min_time <= 0 || threshold < 0) {
+        cerr << "usage: benchmark [--format csv|json] [--filter text] [--min-time seconds]" << endl;
+        cerr << "                 [--baseline file] [--threshold fraction] [--save file]" << endl;
+        return 2;
+    }
+
+    BenchmarkSuite suite(min_time, filter);
+    deck_benchmarks(suite);
+    player_benchmarks(suite);
+    map_benchmarks(suite);
+    game_benchmarks(suite);
+
+    if (format == "json") {
+        suite.write_json(cout);
+    } else {
+        suite.write_csv(cout);
+    }
+    if (!save.empty()) {
+        ofstream out(save);
+        suite.write_csv(out);
+    }
+    if (!baseline.empty()) {
+        cout << endl;
+        int regressions = suite.compare(baseline, threshold, cout);
+        if (regressions < 0) {
+            cerr << "cannot read baseline " << baseline << endl;
+            return 2;
+        }
+        cout << regressions << " regressions over " << threshold * 100 << "%" << endl;
+        return regressions > 0 ? 1 : 0;
+    }
+    return 0;
+}
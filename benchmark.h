@@ -0,0 +1,156 @@
+/*
+ * File:   benchmark.h
+ *
+ * Minimal benchmark harness: timing loops, CSV/JSON reports and comparison
+ * against a stored baseline.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define BENCH_REPETITIONS 9
+
+struct BenchResult {
+    std::string name;
+    double ns_per_op; // median over BENCH_REPETITIONS runs
+    double min_ns_per_op;
+    long long iterations; // per run
+};
+
+// Function to keep the compiler from optimizing away a value the benchmark computes
+
+template <class T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Class: BenchmarkSuite
+ * Description:
+ * Runs named benchmarks and collects their results. A benchmark is a function
+ * that performs `iterations` operations. The suite first doubles the
+ * iteration count until one run takes a tenth of min_seconds, scales it to
+ * fill min_seconds, then times BENCH_REPETITIONS runs and keeps the median,
+ * which is far less noisy than the mean on a shared machine.
+ *
+ * Baselines are CSV files in the same format `write_csv` produces. They are
+ * compared on the fastest run rather than the median, as interference from
+ * other processes only ever makes a run slower: a result regresses when its
+ * fastest run is more than `threshold` (0.10 is 10%) slower than the
+ * baseline's.
+ *
+ * Functionality:
+ * - `run`: Times one benchmark, unless the filter excludes it.
+ * - `write_csv` / `write_json`: Reports every result.
+ * - `compare`: Reports every result against a baseline and counts regressions.
+ */
+class BenchmarkSuite {
+public:
+
+    BenchmarkSuite(double min_seconds, const std::string& filter) : min_seconds(min_seconds), filter(filter) {
+    }
+
+    template <class F>
+    void run(const std::string& name, F body) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) {
+            return;
+        }
+
+        long long iterations = 1;
+        while (true) {
+            double seconds = time(body, iterations);
+            if (seconds >= min_seconds / 10 || iterations >= (1LL << 40)) {
+                iterations = std::max(1LL, (long long) (iterations * (min_seconds / BENCH_REPETITIONS) / std::max(seconds, 1e-9)));
+                break;
+            }
+            iterations *= 2;
+        }
+
+        std::vector<double> samples;
+        for (int r = 0; r < BENCH_REPETITIONS; r++) {
+            samples.push_back(time(body, iterations) * 1e9 / iterations);
+        }
+        std::sort(samples.begin(), samples.end());
+        results.push_back(BenchResult{name, samples[BENCH_REPETITIONS / 2], samples[0], iterations});
+    }
+
+    const std::vector<BenchResult>& get_results() const {
+        return results;
+    }
+
+    void write_csv(std::ostream& out) const {
+        out << "name,ns_per_op,min_ns_per_op,iterations" << std::endl;
+        for (const BenchResult& result : results) {
+            out << result.name << "," << result.ns_per_op << "," << result.min_ns_per_op << "," << result.iterations << std::endl;
+        }
+    }
+
+    void write_json(std::ostream& out) const {
+        out << "{\"benchmarks\": [" << std::endl;
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult& result = results[i];
+            out << "  {\"name\": \"" << result.name << "\", \"ns_per_op\": " << result.ns_per_op;
+            out << ", \"min_ns_per_op\": " << result.min_ns_per_op << ", \"iterations\": " << result.iterations << "}";
+            out << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+        out << "]}" << std::endl;
+    }
+
+    // Function to compare every result with the baseline CSV at path, returns the number of regressions
+    // or -1 if the baseline cannot be read
+
+    int compare(const std::string& path, double threshold, std::ostream& out) const {
+        std::ifstream in(path);
+        if (!in) {
+            return -1;
+        }
+        std::map<std::string, double> baseline;
+        std::string line;
+        std::getline(in, line); // header
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string name, median, fastest;
+            if (std::getline(fields, name, ',') && std::getline(fields, median, ',') && std::getline(fields, fastest, ',')) {
+                baseline[name] = std::stod(fastest);
+            }
+        }
+
+        int regressions = 0;
+        out << "name,baseline_min_ns,min_ns_per_op,change,status" << std::endl;
+        for (const BenchResult& result : results) {
+            auto found = baseline.find(result.name);
+            if (found == baseline.end()) {
+                out << result.name << ",," << result.min_ns_per_op << ",,new" << std::endl;
+                continue;
+            }
+            double change = result.min_ns_per_op / found->second - 1;
+            const char* status = change > threshold ? "REGRESSION" : change < -threshold ? "improved" : "ok";
+            regressions += change > threshold;
+            out << result.name << "," << found->second << "," << result.min_ns_per_op << "," << change << "," << status << std::endl;
+        }
+        return regressions;
+    }
+
+private:
+    double min_seconds;
+    std::string filter;
+    std::vector<BenchResult> results;
+
+    template <class F>
+    static double time(F& body, long long iterations) {
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+#endif /* BENCHMARK_H */
@@ -0,0 +1,215 @@
+/*
+ * File:   bot_tuner.h
+ *
+ * Tunes the weights of a HeuristicBot by self-play against simple_policy,
+ * with SPSA (simultaneous perturbation stochastic approximation): every
+ * generation plays two perturbed weight vectors on the same deals and steps
+ * along the difference.
+ */
+
+#ifndef BOT_TUNER_H
+#define BOT_TUNER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "game_engine.h"
+#include "heuristic_bot.h"
+#include "rng.h"
+#include "thread_pool.h"
+
+#define TUNER_MAGIC "UNOTUNE2"
+#define TUNE_GAMES_PER_BATCH 512
+
+struct TunerConfig {
+    long long games; // deals per generation, each played once by either candidate
+    int amount_players;
+    uint64_t seed;
+    double step; // SPSA a: how far a generation moves the weights
+    double perturbation; // SPSA c: how far the two candidates sit from the weights
+    double stability; // SPSA A: generations over which the first steps are damped
+
+    TunerConfig() : games(1000000), amount_players(4), seed(1), step(4.0), perturbation(0.2), stability(10) {
+    }
+};
+
+/**
+ * Struct: TunerGeneration
+ * Description:
+ * What one generation did: the win rates of the two candidates against
+ * simple_policy, the games played and how long they took.
+ */
+struct TunerGeneration {
+    int generation;
+    long long games;
+    double seconds;
+    double win_plus;
+    double win_minus;
+};
+
+// Function to play n_games games on pool in which the seat (game i % amount_players) of game i is played by bot
+// and every other seat by simple_policy, returns how many of them bot won. Game i is seeded with game_seed(seed, i),
+// so a run does not depend on the number of threads and two bots measured with one seed play the same deals.
+
+inline long long bot_wins(const HeuristicBot& bot, long long n_games, int amount_players, uint64_t seed, WorkStealingPool& pool) {
+    struct alignas(64) Worker {
+        GameEngine engine;
+        long long wins = 0;
+    };
+    std::vector<Worker> workers(pool.get_threads());
+    uint32_t n_batches = (n_games + TUNE_GAMES_PER_BATCH - 1) / TUNE_GAMES_PER_BATCH;
+    pool.run(n_batches, [&](int w, uint32_t batch) {
+        Worker& worker = workers[w];
+        GameEngine& engine = worker.engine;
+        long long first = (long long) batch * TUNE_GAMES_PER_BATCH;
+        long long last = std::min(first + TUNE_GAMES_PER_BATCH, n_games);
+        for (long long i = first; i < last; i++) {
+            int seat = i % amount_players;
+            engine.new_game(amount_players, game_seed(seed, i));
+            while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+                engine.step(engine.get_turn() == seat ? bot.choose(engine) : simple_policy(engine));
+            }
+            worker.wins += engine.get_winner() == seat ? 1 : 0;
+        }
+    });
+    long long wins = 0;
+    for (const Worker& worker : workers) {
+        wins += worker.wins;
+    }
+    return wins;
+}
+
+/**
+ * Class: BotTuner
+ * Description:
+ * SPSA over the HeuristicWeights. Generation k draws a random sign for every
+ * weight, plays the weights moved by +c_k and by -c_k along those signs on
+ * the same `games` deals (common random numbers: both candidates see the
+ * same cards, seats and shuffles, so the difference between their win rates
+ * is far less noisy than either rate), and moves the weights by a_k times
+ * that difference over 2 c_k, along the signs. The gains shrink as
+ * a_k = a / (k + 1 + A)^0.602 and c_k = c / (k + 1)^0.101, Spall's usual
+ * exponents. The deals of generation k come from game_seed(seed, k), so a run
+ * is repeatable on any number of threads and resumes exactly from a
+ * checkpoint.
+ *
+ * Functionality:
+ * - `run_generation`: Plays one generation and updates the weights.
+ * - `save` / `load`: Writes or reads a checkpoint (generation, config, weights) as text. A checkpoint
+ *   only resumes a run with the same TunerConfig, as the next generations would not be the same otherwise.
+ * - `get_weights` / `get_generation`: Where the tuning stands.
+ */
+class BotTuner {
+public:
+
+    BotTuner(const TunerConfig& config, WorkStealingPool& pool) : config(config), pool(pool), generation(0) {
+    }
+
+    TunerGeneration run_generation() {
+        double k = generation;
+        double step = config.step / std::pow(k + 1 + config.stability, 0.602);
+        double perturbation = config.perturbation / std::pow(k + 1, 0.101);
+        uint64_t seed = game_seed(config.seed, generation);
+
+        Rng signs(seed ^ 0x5157a0ULL);
+        double delta[HEURISTIC_FEATURES];
+        HeuristicWeights plus = weights, minus = weights;
+        for (int i = 0; i < HEURISTIC_FEATURES; i++) {
+            delta[i] = (signs.next() >> 63) != 0 ? 1 : -1;
+            plus.w[i] += perturbation * delta[i];
+            minus.w[i] -= perturbation * delta[i];
+        }
+
+        TunerGeneration result;
+        auto start = std::chrono::steady_clock::now();
+        result.win_plus = (double) bot_wins(HeuristicBot(plus), config.games, config.amount_players, seed, pool) / config.games;
+        result.win_minus = (double) bot_wins(HeuristicBot(minus), config.games, config.amount_players, seed, pool) / config.games;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.games = 2 * config.games;
+        result.generation = generation;
+
+        // with signs of +-1, dividing by delta is multiplying by it
+        double gradient = (result.win_plus - result.win_minus) / (2 * perturbation);
+        for (int i = 0; i < HEURISTIC_FEATURES; i++) {
+            weights.w[i] += step * gradient * delta[i];
+        }
+        generation++;
+        return result;
+    }
+
+    // Function to write the checkpoint through a temporary file, so a crash never leaves half of one behind
+
+    bool save(const std::string& path) const {
+        std::string temp = path + ".tmp";
+        FILE* file = fopen(temp.c_str(), "w");
+        if (file == NULL) {
+            return false;
+        }
+        bool ok = fprintf(file, "%s %d %d\n", TUNER_MAGIC, generation, HEURISTIC_FEATURES) > 0;
+        ok = ok && fprintf(file, "config %lld %d %llu %.17g %.17g %.17g\n", config.games, config.amount_players,
+                (unsigned long long) config.seed, config.step, config.perturbation, config.stability) > 0;
+        for (int i = 0; i < HEURISTIC_FEATURES; i++) {
+            ok = ok && fprintf(file, "%s %.17g\n", feature_name(i), weights.w[i]) > 0;
+        }
+        ok = fclose(file) == 0 && ok;
+        return ok && rename(temp.c_str(), path.c_str()) == 0;
+    }
+
+    // Function to resume from a checkpoint, false (and nothing changed) when there is none, it does not fit or it was
+    // written with another config
+
+    bool load(const std::string& path) {
+        FILE* file = fopen(path.c_str(), "r");
+        if (file == NULL) {
+            return false;
+        }
+        char magic[16];
+        char name[64];
+        int saved_generation = 0, features = 0;
+        TunerConfig saved_config;
+        unsigned long long saved_seed = 0;
+        HeuristicWeights saved;
+        bool ok = fscanf(file, "%15s %d %d", magic, &saved_generation, &features) == 3
+                && std::string(magic) == TUNER_MAGIC && features == HEURISTIC_FEATURES;
+        ok = ok && fscanf(file, " config %lld %d %llu %lf %lf %lf", &saved_config.games, &saved_config.amount_players,
+                &saved_seed, &saved_config.step, &saved_config.perturbation, &saved_config.stability) == 6;
+        saved_config.seed = saved_seed;
+        ok = ok && same_config(saved_config);
+        for (int i = 0; ok && i < HEURISTIC_FEATURES; i++) {
+            ok = fscanf(file, "%63s %lf", name, &saved.w[i]) == 2 && std::string(name) == feature_name(i);
+        }
+        fclose(file);
+        if (ok) {
+            generation = saved_generation;
+            weights = saved;
+        }
+        return ok;
+    }
+
+    const HeuristicWeights& get_weights() const {
+        return weights;
+    }
+
+    int get_generation() const {
+        return generation;
+    }
+
+    // Function to check whether other would tune exactly as config does (%.17g keeps every double exact)
+
+    bool same_config(const TunerConfig& other) const {
+        return other.games == config.games && other.amount_players == config.amount_players && other.seed == config.seed
+                && other.step == config.step && other.perturbation == config.perturbation && other.stability == config.stability;
+    }
+
+private:
+    TunerConfig config;
+    WorkStealingPool& pool;
+    int generation;
+    HeuristicWeights weights;
+};
+
+#endif /* BOT_TUNER_H */
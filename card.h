@@ -0,0 +1,201 @@
+/*
+ * File:   card.h
+ *
+ * The UNO card type shared by the interactive game and the headless engine.
+ */
+
+#ifndef CARD_H
+#define CARD_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#define DECK_SIZE 108
+#define MAX_DECKS 8 // most decks shuffled together for one game
+
+/* card numbers of the action cards (0-9 are plain numbers) */
+#define DRAW_TWO 10
+#define SKIP 11
+#define REVERSE 12
+#define WILD 13
+#define WILD_DRAW_FOUR 14
+
+/* a packed card is color * 16 + number, so every card fits in CARD_CODES */
+#define CARD_CODES 80
+
+enum COLOR {
+    wild, red, green, blue, yellow
+};
+
+/**
+ * Class: card
+ * Description:
+ * One UNO card packed into a single byte: the number (0-14) in the low four
+ * bits and the color (0-4) above it. A whole hand, deck or game state stays a
+ * handful of cache lines, and the packed byte indexes the lookup tables below
+ * directly.
+ */
+class card {
+public:
+
+    /**
+     * Equality operator.
+     * @param other Other card to check equality with. (can be put as the next card)
+     */
+    bool operator==(card const& other) const;
+
+    /**
+     * Inequality operator.
+     * @param other Other card to check inequality with.
+     */
+    bool operator!=(card const& other) const {
+        return !(*this == other);
+    }
+
+    constexpr card() : code(0) {
+
+    }
+
+    constexpr card(int num, COLOR col) : code(static_cast<uint8_t> (col * 16 + num)) {
+
+    }
+
+    // 0-9 numbers, +2, skip, reverse, all color, +4 (all color)
+
+    constexpr int number() const {
+        return code & 15;
+    }
+
+    // 5 colors: red, green, blue, yellow, and no color
+
+    constexpr COLOR color() const {
+        return static_cast<COLOR> (code >> 4);
+    }
+
+    void set_color(COLOR col) {
+        code = static_cast<uint8_t> (col * 16 + number());
+    }
+
+    // The packed byte, in [0, CARD_CODES)
+
+    constexpr uint8_t get_code() const {
+        return code;
+    }
+
+private:
+    uint8_t code;
+};
+
+// Function to build the 108 cards of a fresh deck in the order deck::create always used
+
+constexpr std::array<card, DECK_SIZE> make_master_deck() {
+    std::array<card, DECK_SIZE> cards{};
+    int size = 0;
+
+    // card rank 0
+    for (int col = red; col <= yellow; col++) {
+        cards[size++] = card(0, static_cast<COLOR> (col));
+    }
+
+    // card rank 1 till 9 , "draw-two", "skip", "reverse"
+    for (int num = 1; num <= REVERSE; num++) {
+        for (int x = 0; x < 2; x++) {
+            for (int col = red; col <= yellow; col++) {
+                cards[size++] = card(num, static_cast<COLOR> (col));
+            }
+        }
+    }
+
+    // card "wild", "wild-draw-four"
+    for (int num = WILD; num <= WILD_DRAW_FOUR; num++) {
+        for (int x = 0; x < 4; x++) {
+            cards[size++] = card(num, wild);
+        }
+    }
+    return cards;
+}
+
+constexpr std::array<card, DECK_SIZE> MASTER_DECK = make_master_deck();
+
+/**
+ * Playability table: bit `candidate` of PLAYABLE[top] is set when a card with
+ * code `candidate` can be put on a card with code `top`, i.e. they share the
+ * number or the color, or either one is wild.
+ */
+struct PlayableMask {
+    uint64_t bits[2];
+};
+
+constexpr std::array<PlayableMask, CARD_CODES> make_playable_table() {
+    std::array<PlayableMask, CARD_CODES> table{};
+    for (int top = 0; top < CARD_CODES; top++) {
+        for (int other = 0; other < CARD_CODES; other++) {
+            int top_num = top & 15, top_col = top >> 4;
+            int other_num = other & 15, other_col = other >> 4;
+            if (top_num == other_num || top_col == other_col || top_col == wild || other_col == wild) {
+                table[top].bits[other >> 6] |= 1ULL << (other & 63);
+            }
+        }
+    }
+    return table;
+}
+
+constexpr std::array<PlayableMask, CARD_CODES> PLAYABLE = make_playable_table();
+
+inline bool card::operator==(card const& other) const {
+    return (PLAYABLE[code].bits[other.code >> 6] >> (other.code & 63)) & 1;
+}
+
+/**
+ * Display names of every card code, built at compile time in the format the
+ * stream operator always wrote ("Number:SKIP   Color:red"), so printing a
+ * card is one copy of a ready string.
+ */
+struct CardName {
+    char text[40]; // NUL terminated
+    uint8_t length;
+};
+
+// Function to append the NUL terminated text to name at compile time
+
+constexpr void append_name(CardName& name, const char* text) {
+    while (*text != 0) {
+        name.text[name.length++] = *text++;
+    }
+    name.text[name.length] = 0;
+}
+
+constexpr std::array<CardName, CARD_CODES> make_card_names() {
+    const char* numbers[16] = {"0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+        "DRAW-2", "SKIP", "REVERSE", "WILD", "DRAW-4-WILD", "15"};
+    const char* colors[5] = {"wild", "red", "green", "blue", "yellow"};
+    std::array<CardName, CARD_CODES> table{};
+    for (int code = 0; code < CARD_CODES; code++) {
+        append_name(table[code], "Number:");
+        append_name(table[code], numbers[code & 15]);
+        append_name(table[code], "   Color:");
+        append_name(table[code], colors[code >> 4]);
+    }
+    return table;
+}
+
+constexpr std::array<CardName, CARD_CODES> CARD_NAMES = make_card_names();
+
+inline const CardName& card_name(card temp_card) {
+    return CARD_NAMES[temp_card.get_code()];
+}
+
+/**
+ * Stream operator that allows a card to be written to standard streams
+ * (like cout).
+ *
+ * @param out Stream to write to.
+ * @param temp_card to write to the stream.
+ */
+inline std::ostream& operator<<(std::ostream& out, card const& temp_card) {
+    const CardName& name = card_name(temp_card);
+    return out.write(name.text, name.length);
+}
+
+#endif /* CARD_H */
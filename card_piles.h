@@ -0,0 +1,199 @@
+/*
+ * File:   card_piles.h
+ *
+ * The main deck and the discard pile of one game, kept in a single ring
+ * with room for every card of the decks the game is played with.
+ */
+
+#ifndef CARD_PILES_H
+#define CARD_PILES_H
+
+#include <algorithm>
+#include <iostream>
+#include "card.h"
+#include "rng.h"
+
+/**
+ * Class: BasicCardPiles
+ * Description:
+ * Both piles of a game as two views of one ring buffer of Capacity cards,
+ * held inside the object: Capacity / DECK_SIZE decks shuffled together.
+ * CardPiles is the single deck of the standard game. The main deck runs
+ * forward from `begin`, bottom card first, so its top is at begin + size - 1.
+ * The discard pile runs backward from begin - 1, bottom card first, so the
+ * two piles meet at their bottoms and each top faces the free slots:
+ *
+ *     ... free | discard top ... discard bottom | main bottom ... main top | free ...
+ *
+ * Drawing and discarding touch one slot each. Recycling the discard pile into
+ * the main deck moves nothing: the cards under the discard top are already
+ * next to the main deck's bottom, so `begin` steps back over them and the
+ * widened range is shuffled in place, while the discard top stays where it
+ * is as the only card left on the discard pile. A game never has more than
+ * Capacity cards, so the two tops can never run into each other.
+ *
+ * Positions in both piles count from the bottom card, as deck::get_cards
+ * does.
+ *
+ * Functionality:
+ * - `reset`: Empties both piles.
+ * - `create`: Puts Capacity / DECK_SIZE copies of MASTER_DECK on the main deck.
+ * - `draw` / `discard`: Takes the top of the main deck, or puts a card on the discard pile.
+ * - `shuffle`: Shuffles the main deck in place.
+ * - `recycle`: Shuffles all of the discard pile but its top card back into the main deck.
+ * - `main_at` / `discard_at`: Read a card by position.
+ * - `get_main` / `get_discard`: Copy a whole pile out, bottom card first.
+ * - `assign`: Replaces both piles.
+ * - `assign_main`: Replaces the main deck with as many cards as it held.
+ */
+template <int Capacity>
+class BasicCardPiles {
+    static_assert(Capacity > 0 && Capacity % DECK_SIZE == 0, "the piles hold whole decks");
+public:
+
+    static constexpr int decks = Capacity / DECK_SIZE;
+
+    BasicCardPiles() : begin(0), main_size(0), discard_size(0) {
+    }
+
+    void reset() {
+        begin = 0;
+        main_size = 0;
+        discard_size = 0;
+    }
+
+    // Function to put every card of the fresh decks, each in MASTER_DECK order, on an empty main deck
+
+    void create() {
+        reset();
+        for (int d = 0; d < decks; d++) {
+            for (int i = 0; i < DECK_SIZE; i++) {
+                slots[d * DECK_SIZE + i] = MASTER_DECK[i];
+            }
+        }
+        main_size = Capacity;
+    }
+
+    bool is_main_empty() const {
+        return main_size == 0;
+    }
+
+    int get_main_size() const {
+        return main_size;
+    }
+
+    int get_discard_size() const {
+        return discard_size;
+    }
+
+    // Function to take the top card of the main deck, which must not be empty
+
+    card draw() {
+        main_size--;
+        return slots[main_slot(main_size)];
+    }
+
+    void discard(card temp_card) {
+        slots[discard_slot(discard_size)] = temp_card;
+        discard_size++;
+    }
+
+    card main_at(int pos) const {
+        return slots[main_slot(pos)];
+    }
+
+    card discard_at(int pos) const {
+        return slots[discard_slot(pos)];
+    }
+
+    // Fisher-Yates over the main deck. When the main deck wraps around the end of the ring the whole ring is
+    // rotated to start at `begin` first, which keeps both piles in order, so the pass indexes plain memory
+
+    void shuffle(Rng& rng) {
+        if (begin + main_size > Capacity) {
+            std::rotate(slots, slots + begin, slots + Capacity);
+            begin = 0;
+        }
+        card* cards = slots + begin;
+        for (int i = main_size - 1; i > 0; i--) {
+            std::swap(cards[i], cards[rng.bounded(i + 1)]);
+        }
+    }
+
+    // Function to turn every discarded card but the top one into the bottom of the main deck and shuffle it
+
+    void recycle(Rng& rng) {
+        if (discard_size == 0) {
+            return;
+        }
+        int moved = discard_size - 1;
+        begin = wrap(begin - moved);
+        main_size += moved;
+        discard_size = 1;
+        shuffle(rng);
+    }
+
+    int get_main(card* out) const {
+        for (int i = 0; i < main_size; i++) {
+            out[i] = main_at(i);
+        }
+        return main_size;
+    }
+
+    int get_discard(card* out) const {
+        for (int i = 0; i < discard_size; i++) {
+            out[i] = discard_at(i);
+        }
+        return discard_size;
+    }
+
+    // Function to replace both piles, each given bottom card first
+
+    void assign(const card* main_cards, int main_count, const card* discard_cards, int discard_count) {
+        begin = 0;
+        main_size = main_count;
+        discard_size = discard_count;
+        for (int i = 0; i < main_count; i++) {
+            slots[main_slot(i)] = main_cards[i];
+        }
+        for (int i = 0; i < discard_count; i++) {
+            slots[discard_slot(i)] = discard_cards[i];
+        }
+    }
+
+    // Function to replace the cards of the main deck, count must be its current size
+
+    void assign_main(const card* cards, int count) {
+        for (int i = 0; i < count; i++) {
+            slots[main_slot(i)] = cards[i];
+        }
+    }
+
+    void print_discard() const {
+        for (int i = 0; i < discard_size; i++) {
+            std::cout << i << ": " << discard_at(i) << std::endl;
+        }
+    }
+
+private:
+    card slots[Capacity];
+    int begin; // slot of the main deck's bottom card
+    int main_size;
+    int discard_size;
+
+    static int wrap(int slot) {
+        return slot < 0 ? slot + Capacity : slot >= Capacity ? slot - Capacity : slot;
+    }
+
+    int main_slot(int pos) const {
+        return wrap(begin + pos);
+    }
+
+    int discard_slot(int pos) const {
+        return wrap(begin - 1 - pos);
+    }
+};
+
+typedef BasicCardPiles<DECK_SIZE> CardPiles;
+
+#endif /* CARD_PILES_H */
@@ -0,0 +1,295 @@
+/*
+ * File:   card_tracker.h
+ *
+ * The cards one seat has not seen, kept up to date as the game goes on, and
+ * the probabilities bots and analysis tools ask about them.
+ */
+
+#ifndef CARD_TRACKER_H
+#define CARD_TRACKER_H
+
+#include "card.h"
+#include "card_piles.h"
+#include "player.h"
+#include "seating.h"
+
+/**
+ * Binomial coefficients C(n, k) for n, k <= DECK_SIZE as doubles, built at
+ * compile time with Pascal's rule. C(108, 54) is about 1e31, far inside the
+ * range of a double.
+ */
+struct BinomialTable {
+    double value[DECK_SIZE + 1][DECK_SIZE + 1];
+};
+
+constexpr BinomialTable make_binomial_table() {
+    BinomialTable table{};
+    for (int n = 0; n <= DECK_SIZE; n++) {
+        table.value[n][0] = 1;
+        for (int k = 1; k <= n; k++) {
+            table.value[n][k] = table.value[n - 1][k - 1] + (k < n ? table.value[n - 1][k] : 0);
+        }
+    }
+    return table;
+}
+
+constexpr BinomialTable BINOMIAL = make_binomial_table();
+
+/**
+ * Class: CardTracker
+ * Description:
+ * What one seat (the observer) has not seen: the main deck and the other
+ * hands together, which is the whole deck minus the observer's hand and the
+ * discard pile. The unseen cards are kept as counts per card code, per colour
+ * and per number, so every question below is a few array reads however far
+ * the game has gone.
+ *
+ * The observer knows which cards are unseen but not where they are. As in
+ * GameEngine::determinize, every way to place them that agrees with the public
+ * hand sizes counts as equally likely: the next card drawn is any unseen card
+ * with the same chance, and an opponent's hand is a random sample of them.
+ * What a player's choices give away (drawing instead of playing, the colour
+ * named for a wild) is not used. When a 7 or a 0 passes the observer's hand
+ * on, those cards count as unseen again.
+ *
+ * Events, each costing time in proportion to the cards it moves:
+ * - `start`: Begins a game, with nothing seen yet.
+ * - `played`: A seat put a card on the discard pile.
+ * - `turned_up`: A card went from the main deck onto the discard pile.
+ * - `drew`: Another seat drew cards, of which only the count is public.
+ * - `observer_drew`: The observer drew a card.
+ * - `chose_color`: The colour named for the wild on top.
+ * - `reshuffled`: The discard pile but its top went back into the main deck.
+ * - `follow`: Applies everything that happened in an engine since the last call.
+ *
+ * Queries, each O(1):
+ * - `p_draw_playable`: Chance the next card drawn can be played on a card.
+ * - `p_holds_color`: Chance a seat holds at least one card of a colour.
+ * - `unseen`, `unseen_code`, `unseen_color`, `unseen_number`: The counts themselves.
+ */
+class CardTracker {
+public:
+
+    CardTracker() {
+        start(2, 0);
+    }
+
+    // Function to begin a game of amount_players seats seen by observer, before anything is dealt
+
+    void start(int amount_players, int observer) {
+        this->amount_players = amount_players;
+        this->observer = observer;
+        for (int code = 0; code < CARD_CODES; code++) {
+            codes[code] = 0;
+        }
+        for (int col = 0; col < 5; col++) {
+            colors[col] = 0;
+        }
+        for (int num = 0; num < 16; num++) {
+            numbers[num] = 0;
+        }
+        total = 0;
+        for (int i = 0; i < DECK_SIZE; i++) {
+            unsee(MASTER_DECK[i]);
+        }
+        for (int i = 0; i < MAX_SEATS; i++) {
+            hand_sizes[i] = 0;
+        }
+        hand = player();
+        pile_size = 0;
+        reshuffles = 0;
+        top = card();
+    }
+
+    // Function to record that seat put temp_card on the discard pile
+
+    void played(int seat, card temp_card) {
+        if (seat == observer) {
+            hand.hand_remove_card(temp_card);
+            unsee(temp_card);
+        }
+        hand_sizes[seat]--;
+        turned_up(temp_card);
+    }
+
+    // Function to record a card going from the main deck straight onto the discard pile, like the starting card
+
+    void turned_up(card temp_card) {
+        see(temp_card);
+        pile[pile_size++] = temp_card;
+        top = temp_card;
+    }
+
+    // Function to record that another seat drew count cards
+
+    void drew(int seat, int count) {
+        hand_sizes[seat] += count;
+    }
+
+    void observer_drew(card temp_card) {
+        see(temp_card);
+        hand.hand_add(temp_card);
+        hand_sizes[observer]++;
+    }
+
+    void chose_color(COLOR col) {
+        top.set_color(col);
+    }
+
+    // Function to record that every discarded card but the top one went back into the main deck
+
+    void reshuffled() {
+        if (pile_size == 0) {
+            return;
+        }
+        for (int i = 0; i < pile_size - 1; i++) {
+            unsee(pile[i]);
+        }
+        pile[0] = pile[pile_size - 1];
+        pile_size = 1;
+    }
+
+    // Function to catch up with engine, which must be the game this tracker started on. The discard
+    // pile is read from where it was last seen, a reshuffle since then returns the whole pile first.
+    // Calling it only on the observer's own turns is as good as after every step.
+
+    template <class Engine>
+    void follow(const Engine& engine) {
+        static_assert(Engine::deck_cards == DECK_SIZE, "a CardTracker follows games played with one deck");
+        const CardPiles& piles = engine.get_piles();
+        if (engine.get_reshuffles() != reshuffles) {
+            for (int i = 0; i < pile_size; i++) {
+                unsee(pile[i]);
+            }
+            pile_size = 0;
+            reshuffles = engine.get_reshuffles();
+        }
+        for (int pos = pile_size; pos < piles.get_discard_size(); pos++) {
+            card temp_card = piles.discard_at(pos);
+            see(temp_card);
+            pile[pile_size++] = temp_card;
+        }
+
+        // the observer's own cards, wherever they came from or went to
+        const player& now = engine.get_player(observer);
+        PlayableMask before = hand.card_mask(), after = now.card_mask();
+        for (int word = 0; word < 2; word++) {
+            for (uint64_t bits = before.bits[word] | after.bits[word]; bits != 0; bits &= bits - 1) {
+                card temp_card = player::from_code(word * 64 + __builtin_ctzll(bits));
+                for (int k = hand.count(temp_card); k < now.count(temp_card); k++) {
+                    see(temp_card);
+                }
+                for (int k = now.count(temp_card); k < hand.count(temp_card); k++) {
+                    unsee(temp_card);
+                }
+            }
+        }
+        hand = now;
+        for (int i = 0; i < amount_players; i++) {
+            hand_sizes[i] = engine.get_player(i).get_size();
+        }
+        top = engine.get_played_card();
+    }
+
+    // Chance that the next card drawn from the main deck can be played on top_card
+
+    double p_draw_playable(card top_card) const {
+        if (total == 0) {
+            return 0;
+        }
+        int col = top_card.color();
+        int num = top_card.number();
+        if (col == wild) {
+            return 1;
+        }
+        // same colour, same number or wild, without counting the cards that are two of those twice
+        int fits = colors[col] + numbers[num] + colors[wild] - codes[col * 16 + num] - codes[wild * 16 + num];
+        return (double) fits / total;
+    }
+
+    double p_draw_playable() const {
+        return p_draw_playable(top);
+    }
+
+    // Chance that seat holds at least one card of col, from how many of its cards could be col
+
+    double p_holds_color(int seat, COLOR col) const {
+        if (seat == observer) {
+            return hand.color_count(col) > 0 ? 1 : 0;
+        }
+        int size = hand_sizes[seat];
+        int others = total - colors[col];
+        if (size <= 0) {
+            return 0;
+        }
+        if (size > others) {
+            return 1;
+        }
+        // one minus the chance that all size cards are drawn from the others
+        return 1 - BINOMIAL.value[others][size] / BINOMIAL.value[total][size];
+    }
+
+    int unseen() const {
+        return total;
+    }
+
+    int unseen_code(card temp_card) const {
+        return codes[temp_card.get_code()];
+    }
+
+    int unseen_color(COLOR col) const {
+        return colors[col];
+    }
+
+    int unseen_number(int num) const {
+        return numbers[num];
+    }
+
+    // Cards left in the main deck, the unseen cards no hand holds
+
+    int deck_size() const {
+        int size = total;
+        for (int i = 0; i < amount_players; i++) {
+            size -= i == observer ? 0 : hand_sizes[i];
+        }
+        return size;
+    }
+
+    int get_observer() const {
+        return observer;
+    }
+
+    card get_top() const {
+        return top;
+    }
+
+private:
+    int amount_players;
+    int observer;
+    int codes[CARD_CODES]; // unseen copies of every card code
+    int colors[5];
+    int numbers[16];
+    int total;
+    int hand_sizes[MAX_SEATS];
+    player hand; // the observer's hand as last seen
+    card pile[DECK_SIZE]; // the discard pile as last seen, bottom card first
+    int pile_size;
+    int reshuffles; // the engine's reshuffle count as of the last follow
+    card top;
+
+    void see(card temp_card) {
+        codes[temp_card.get_code()]--;
+        colors[temp_card.color()]--;
+        numbers[temp_card.number()]--;
+        total--;
+    }
+
+    void unsee(card temp_card) {
+        codes[temp_card.get_code()]++;
+        colors[temp_card.color()]++;
+        numbers[temp_card.number()]++;
+        total++;
+    }
+};
+
+#endif /* CARD_TRACKER_H */
@@ -0,0 +1,316 @@
+/*
+ * File:   client.cpp
+ *
+ * Clients of the game server: a load generator that keeps many tables busy
+ * with simple bot clients and reports move latency, and a terminal client to
+ * play one seat by hand.
+ *
+ * usage: uno_client --load <address> [tables] [players] [seconds]
+ *        uno_client --play <address> [players] [bots]
+ *
+ * The load generator sits players clients at every table, so the server
+ * plays no seats. A move's latency runs from sending the answer to reading
+ * the server's reply to it. Tables per core is the number of tables the
+ * server would hold at this pace with one core fully busy: tables times
+ * seconds over the CPU seconds the server used, as it reports them.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/epoll.h>
+#include "card.h"
+#include "local_socket.h"
+#include "seating.h"
+using namespace std;
+
+static int64_t now_ns() {
+    return chrono::duration_cast<chrono::nanoseconds> (chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool send_line(int fd, const string& line) {
+    string data = line + "\n";
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+        if (n < 0 && errno != EINTR && errno != EAGAIN) {
+            return false;
+        }
+        done += n > 0 ? n : 0;
+    }
+    return true;
+}
+
+// Function to ask the server for the CPU time it used so far, in seconds
+
+static double server_cpu_seconds(const LocalAddress& address) {
+    int fd = address.connect_to();
+    if (fd < 0 || !send_line(fd, "STATS")) {
+        return -1;
+    }
+    LineBuffer in;
+    string line;
+    while (!in.next_line(line)) {
+        if (!in.fill(fd)) {
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+    long long cpu_us = 0;
+    return sscanf(line.c_str(), "STATS %lld", &cpu_us) == 1 ? cpu_us / 1e6 : -1;
+}
+
+/**
+ * Class: BotClient
+ * Description:
+ * One seat of the load generator. Answers every prompt at once the way
+ * simple_policy would: the first colored card that fits, else a wild naming
+ * the colour held most, else a draw, and always play a card it drew.
+ */
+class BotClient {
+public:
+    int fd;
+    LineBuffer in;
+    int64_t sent_ns; // when the answer still waiting for its reply went out, 0 when none is
+    string color; // the colour named for the wild just played
+
+    explicit BotClient(int fd) : fd(fd), sent_ns(0) {
+    }
+
+    // Function to react to one line of the server, returns the answer, led by the prompt number, or an empty string
+
+    string answer(const string& line) {
+        istringstream fields(line);
+        string kind, prompt;
+        fields >> kind >> prompt;
+        if (kind == "MOVE") {
+            return prompt + " " + choose_move(fields);
+        } else if (kind == "COLOR") {
+            return prompt + " " + color;
+        } else if (kind == "DRAWN") {
+            return prompt + " y";
+        }
+        return "";
+    }
+
+private:
+
+    string choose_move(istringstream& fields) {
+        int top = 0, forced = 0, size = 0;
+        fields >> top >> forced >> size;
+        int wild_index = -1;
+        int colors[5] = {};
+        int best = -1;
+        for (int i = 0; i < size; i++) {
+            int code = 0;
+            fields >> code;
+            colors[code >> 4]++;
+            bool fits = (PLAYABLE[top].bits[code >> 6] >> (code & 63)) & 1;
+            if (fits && (code >> 4) != wild && best < 0) {
+                best = i;
+            } else if (fits && (code >> 4) == wild && wild_index < 0) {
+                wild_index = i;
+            }
+        }
+        if (best >= 0) {
+            return to_string(best);
+        }
+        if (wild_index < 0) {
+            return "-1";
+        }
+        const char* names[5] = {"wild", "red", "green", "blue", "yellow"};
+        int most = red;
+        for (int col = green; col <= yellow; col++) {
+            most = colors[col] > colors[most] ? col : most;
+        }
+        color = names[most];
+        return to_string(wild_index);
+    }
+};
+
+int load(const LocalAddress& address, int tables, int players, double seconds) {
+    raise_file_limit();
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    vector<BotClient> clients;
+    clients.reserve((size_t) tables * players);
+    for (int i = 0; i < tables * players; i++) {
+        int fd = address.connect_to();
+        if (fd < 0 || !set_nonblocking(fd)) {
+            cerr << "could only open " << i << " connections" << endl;
+            return 1;
+        }
+        clients.push_back(BotClient(fd));
+    }
+
+    double cpu_before = server_cpu_seconds(address);
+    int64_t start = now_ns();
+    int64_t deadline = start + (int64_t) (seconds * 1e9);
+    string join = "JOIN " + to_string(players) + " 0";
+    for (size_t i = 0; i < clients.size(); i++) {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, clients[i].fd, &event);
+        send_line(clients[i].fd, join);
+    }
+
+    vector<uint32_t> latencies_us;
+    long long games = 0, timeouts = 0, refused = 0;
+    epoll_event events[256];
+    string line;
+    while (now_ns() < deadline) {
+        int n = epoll_wait(epoll_fd, events, 256, 100);
+        for (int e = 0; e < n; e++) {
+            BotClient& client = clients[events[e].data.u64];
+            if (!client.in.fill(client.fd)) {
+                cerr << "server closed a connection" << endl;
+                return 1;
+            }
+            while (client.in.next_line(line)) {
+                int64_t now = now_ns();
+                if (client.sent_ns != 0) {
+                    latencies_us.push_back((now - client.sent_ns) / 1000);
+                    client.sent_ns = 0;
+                }
+                if (line.compare(0, 4, "END ") == 0) {
+                    games++;
+                    send_line(client.fd, join);
+                    continue;
+                }
+                timeouts += line.compare(0, 8, "TIMEOUT ") == 0;
+                refused += line == "INVALID";
+                string answer = client.answer(line);
+                if (!answer.empty()) {
+                    client.sent_ns = now_ns();
+                    send_line(client.fd, answer);
+                }
+            }
+        }
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+    double cpu = server_cpu_seconds(address) - cpu_before;
+    for (BotClient& client : clients) {
+        close(client.fd);
+    }
+    close(epoll_fd);
+
+    sort(latencies_us.begin(), latencies_us.end());
+    size_t moves = latencies_us.size();
+    cout << "tables,players,seconds,games,moves,moves_per_s,p50_us,p99_us,timeouts,refused,server_cpu_s,tables_per_core" << endl;
+    cout << tables << "," << players << "," << elapsed << "," << games << "," << moves << "," << moves / elapsed << ",";
+    cout << (moves ? latencies_us[moves / 2] : 0) << "," << (moves ? latencies_us[moves * 99 / 100] : 0) << ",";
+    cout << timeouts << "," << refused << "," << cpu << "," << (cpu > 0 ? tables * elapsed / cpu : 0) << endl;
+    return 0;
+}
+
+// Function to write a packed card code the way the game prints cards
+
+string card_text(int code) {
+    const CardName& name = CARD_NAMES[code];
+    return string(name.text, name.length);
+}
+
+int play(const LocalAddress& address, int players, int bots) {
+    int fd = address.connect_to();
+    if (fd < 0 || !send_line(fd, "JOIN " + to_string(players) + " " + to_string(bots))) {
+        return 1;
+    }
+    cout << "waiting for " << players - bots << " players" << endl;
+    LineBuffer in;
+    string line;
+    while (true) {
+        if (!in.next_line(line)) {
+            if (!in.fill(fd)) {
+                cout << "server closed the connection" << endl;
+                return 1;
+            }
+            continue;
+        }
+        istringstream fields(line);
+        string kind;
+        fields >> kind;
+        string answer, prompt;
+        if (kind == "START") {
+            int seat = 0;
+            fields >> players >> seat;
+            cout << "game of " << players << " started, you are PLAYER " << seat + 1 << endl;
+        } else if (kind == "MOVE") {
+            int top = 0, forced = 0, size = 0;
+            fields >> prompt >> top >> forced >> size;
+            if (forced != 0) {
+                cout << "Forced Draw-" << forced << endl;
+            }
+            cout << "Played Card: " << card_text(top) << endl;
+            for (int i = 0; i < size; i++) {
+                int code = 0;
+                fields >> code;
+                cout << i << ":  " << card_text(code) << endl;
+            }
+            cout << "which card do you want to play? (-1 to draw): ";
+            cin >> answer;
+        } else if (kind == "COLOR") {
+            fields >> prompt;
+            cout << "Please choose a color (red , green, blue, yellow) :";
+            cin >> answer;
+        } else if (kind == "DRAWN") {
+            int code = 0;
+            fields >> prompt >> code;
+            cout << "DRAWN CARD: " << card_text(code) << endl << "Do you want to play the drawn card [y/n] : ";
+            cin >> answer;
+        } else if (kind == "INVALID") {
+            cout << "card cannot be played" << endl;
+        } else if (kind == "TIMEOUT") {
+            string move, color;
+            int code = 0;
+            fields >> move >> code >> color;
+            cout << "too slow, the server ";
+            if (move == "PLAY") {
+                cout << "played " << card_text(code) << (color.empty() ? "" : " naming " + color) << " for you" << endl;
+            } else {
+                cout << (move == "DRAW" ? "drew a card" : "kept the drawn card") << " for you" << endl;
+            }
+        } else if (kind == "END") {
+            int winner = -1;
+            fields >> winner;
+            cout << (winner < 0 ? string("nobody won") : "PLAYER " + to_string(winner + 1) + " has won the game.") << endl;
+            close(fd);
+            return 0;
+        }
+        if (!cin) {
+            close(fd);
+            return 0;
+        }
+        if (!answer.empty() && !send_line(fd, prompt + " " + answer)) {
+            return 1;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    LocalAddress address;
+    string mode = argc > 1 ? argv[1] : "";
+    if (argc < 3 || !address.parse(argv[2]) || (mode != "--load" && mode != "--play")) {
+        cerr << "usage: uno_client --load <address> [tables] [players] [seconds]" << endl;
+        cerr << "       uno_client --play <address> [players] [bots]" << endl;
+        return 2;
+    }
+    if (mode == "--load") {
+        int tables = argc > 3 ? atoi(argv[3]) : 1000;
+        int players = argc > 4 ? atoi(argv[4]) : 2;
+        double seconds = argc > 5 ? atof(argv[5]) : 5;
+        if (tables <= 0 || players < 2 || players > MAX_SEATS || seconds <= 0) {
+            cerr << "invalid load arguments" << endl;
+            return 2;
+        }
+        return load(address, tables, players, seconds);
+    }
+    int players = argc > 3 ? atoi(argv[3]) : 4;
+    int bots = argc > 4 ? atoi(argv[4]) : players - 1;
+    return play(address, players, bots);
+}
@@ -0,0 +1,254 @@
+/*
+ * File:   deck.h
+ *
+ * The draw and discard piles of an UNO game.
+ */
+
+#ifndef DECK_H
+#define DECK_H
+
+#include <iostream>
+#include <list>
+#include <algorithm>
+#include "card.h"
+#include "rng.h"
+
+/**
+ * Class: basic_deck
+ * Description:
+ * The `basic_deck` class represents a deck of UNO cards. It is derived from the `card` class
+ * and includes functionalities to manage and manipulate the deck, such as shuffling,
+ * drawing cards, and checking the status of the deck.
+ *
+ * Functionality:
+ * - `isDeckEmpty`: Checks if the deck is empty.
+ * - `reshuffle`: Reshuffles the entire deck.
+ * - `addCardToBottom` / `draw_bottom`: Adds or takes the bottom card, simulating a queue-like behavior.
+ *   `addCardToBottom` and `add_card` return -1 and leave the deck as it was when it is full.
+ * - `drawMultiple`: Draws a specific number of cards from the top of the deck.
+ * - `removeCard`: Removes a specific card from the deck, if present.
+ * - `create`: Fills the deck up with whole fresh decks of UNO cards.
+ * - `print_deck`: Prints the current state of the deck to the console.
+ * - `get_size`: Gets the current size of the deck.
+ * - `at`: Reads one card by position, the bottom card is 0.
+ * - `get_cards` / `assign`: Copies out or replaces all cards at once, bottom card first.
+ * - `shuffle`: Shuffles the deck using the Fisher-Yates algorithm.
+ *   `reshuffle` and `quick_shuffle` are the same shuffle, all three take the
+ *   generator explicitly so that a seed fully determines the order.
+ * - `draw`: Draws the top card from the deck.
+ * - `add_card`: Adds a card to the deck.
+ * - `copy`: Copies the content of another deck.
+ * - `clear`: Empties the deck.
+ *
+ * The storage is a ring of Capacity cards inside the deck itself, starting at
+ * the bottom card, so both ends of the deck take and give cards in constant
+ * time and no deck ever allocates. `deck` holds one deck of DECK_SIZE cards.
+ */
+
+template <int Capacity>
+class basic_deck : public card {
+    static_assert(Capacity > 0 && Capacity % DECK_SIZE == 0, "a deck holds whole decks");
+private:
+    card slots[Capacity];
+    int bottom; // index in slots of the bottom card
+    int size;
+
+    // Function to map a position counted from the bottom card to its index in slots
+
+    int slot(int pos) const {
+        pos += bottom;
+        return pos >= Capacity ? pos - Capacity : pos;
+    }
+
+public:
+
+    basic_deck() {
+        bottom = 0;
+        size = 0;
+    }
+
+    bool isDeckEmpty() const {
+        return size <= 0;
+    }
+
+    // Function to reshuffle the entire deck
+
+    void reshuffle(Rng& rng) {
+        shuffle(rng);
+    }
+
+    // Function to add a card to the bottom of the deck (like putting it at the end of the queue)
+
+    int addCardToBottom(card temp_card) {
+        if (size >= Capacity) {
+            return -1;
+        }
+        // Use a queue-like behavior to add at the end: the ring grows downwards
+        bottom = bottom == 0 ? Capacity - 1 : bottom - 1;
+        slots[bottom] = temp_card;
+        size++;
+        return 0;
+    }
+
+    // Function to take the bottom card of the deck (the front of the queue)
+
+    card draw_bottom() {
+        if (size <= 0) {
+            std::cout << "Deck is empty!" << std::endl;
+
+            return card();
+        }
+        card temp_card = slots[bottom];
+        bottom = slot(1);
+        size--;
+        return temp_card;
+    }
+
+    // Function to draw a specific number of cards from the deck
+
+    std::list<card> drawMultiple(int numCards) {
+        std::list<card> drawnCards;
+        for (int i = 0; i < numCards && size > 0; ++i) {
+            drawnCards.push_back(slots[slot(size - 1)]);
+            size--;
+        }
+        return drawnCards;
+    }
+
+    // Function to remove a specific card from the deck (if present)
+
+    bool removeCard(const card& targetCard) {
+        // match the exact card, operator== means "can be played on"
+        int pos = 0;
+        while (pos < size && slots[slot(pos)].get_code() != targetCard.get_code()) {
+            pos++;
+        }
+        if (pos == size) {
+            return false;
+        }
+        // close the gap from whichever end is nearer
+        if (pos < size / 2) {
+            for (int i = pos; i > 0; i--) {
+                slots[slot(i)] = slots[slot(i - 1)];
+            }
+            bottom = slot(1);
+        } else {
+            for (int i = pos; i < size - 1; i++) {
+                slots[slot(i)] = slots[slot(i + 1)];
+            }
+        }
+        size--;
+        return true;
+    }
+
+    // Function to append the cards of fresh decks, copied from the compile-time MASTER_DECK, as many whole decks as fit
+
+    void create() {
+        while (size + DECK_SIZE <= Capacity) {
+            // a fresh deck goes around the ring in at most two pieces
+            int pos = slot(size);
+            int first = std::min(DECK_SIZE, Capacity - pos);
+            std::copy(MASTER_DECK.begin(), MASTER_DECK.begin() + first, slots + pos);
+            std::copy(MASTER_DECK.begin() + first, MASTER_DECK.end(), slots);
+            size += DECK_SIZE;
+        }
+    }
+
+    void print_deck() const {
+        for (int i = 0; i < size; i++) {
+            std::cout << i << ": " << slots[slot(i)] << std::endl;
+        }
+    }
+
+    int get_size() const {
+        return size;
+    }
+
+    card at(int pos) const {
+        return slots[slot(pos)];
+    }
+
+    // Function to copy out the cards of the deck, bottom card first, returns how many there are
+
+    int get_cards(card* out) const {
+        for (int i = 0; i < size; i++) {
+            out[i] = slots[slot(i)];
+        }
+        return size;
+    }
+
+    // Function to replace the content of the deck with count cards, bottom card first, at most Capacity
+
+    void assign(const card* cards, int count) {
+        count = std::min(count, Capacity);
+        std::copy(cards, cards + count, slots);
+        bottom = 0;
+        size = count;
+    }
+
+    basic_deck(const basic_deck& other) {
+        copy(other);
+    }
+
+    const basic_deck& operator=(const basic_deck& other) {
+        if (this != &other) {
+            copy(other);
+        }
+        return *this;
+    }
+
+    // Fisher-Yates shuffle: one pass, every card swapped with an unbiased pick from the cards not yet placed.
+    // A deck that wraps around the end of the ring is turned back into one piece first, so the pass indexes
+    // plain memory; the order of the cards, and so the result for a seed, is the same either way
+
+    void shuffle(Rng& rng) {
+        if (bottom + size > Capacity) {
+            std::rotate(slots, slots + bottom, slots + Capacity);
+            bottom = 0;
+        }
+        card* cards = slots + bottom;
+        for (int i = size - 1; i > 0; i--) {
+            std::swap(cards[i], cards[rng.bounded(i + 1)]);
+        }
+    }
+
+    card draw() {
+        if (size <= 0) {
+            std::cout << "Deck is empty!" << std::endl;
+
+            return card();
+        }
+        size--;
+        return slots[slot(size)];
+    }
+
+    int add_card(card temp_card) {
+        if (size < Capacity) {
+            slots[slot(size)] = temp_card;
+            size++;
+            return 0;
+        } else
+            return -1;
+    }
+
+    void quick_shuffle(Rng& rng) {
+        shuffle(rng);
+    }
+
+    void copy(const basic_deck& other) {
+        size = other.size;
+        bottom = 0;
+        other.get_cards(slots);
+    }
+
+    void clear() {
+        bottom = 0;
+        size = 0;
+    }
+
+
+};
+
+typedef basic_deck<DECK_SIZE> deck;
+
+#endif /* DECK_H */
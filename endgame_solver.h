@@ -0,0 +1,609 @@
+/*
+ * File:   endgame_solver.h
+ *
+ * Exact expectimax search for two-player endgames, where both hands are open
+ * and only the order of the main deck is left to chance.
+ */
+
+#ifndef ENDGAME_SOLVER_H
+#define ENDGAME_SOLVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "card.h"
+#include "game_engine.h"
+#include "player.h"
+#include "rng.h"
+#include "thread_pool.h"
+#include "transposition_table.h"
+
+#define SOLVER_MAX_DEPTH 64
+#define MAX_COPIES 4 // most copies of one card code in a deck
+
+/* solver move keys: card code * 4 + named colour - 1 (0 for coloured cards), or one of these */
+#define KEY_DRAW 1020
+#define KEY_PLAY_DRAWN 1021
+#define KEY_KEEP_DRAWN 1022
+#define KEY_NONE 1023
+
+/**
+ * Random keys for Zobrist hashing. A position's hash is the XOR of one key per
+ * (hand, card code, copies held), per (card code, copies in the main deck) and
+ * one for each of the top card, whose turn it is, the direction, a pending
+ * drawn card and the number of forced draws still to take. The discard pile is
+ * whatever no hand and no main deck holds, so it needs no keys of its own.
+ * Copies 0 hash to 0, so an absent card costs nothing.
+ */
+struct ZobristKeys {
+    uint64_t hand[2][CARD_CODES][MAX_COPIES + 1];
+    uint64_t pile[CARD_CODES][MAX_COPIES + 1];
+    uint64_t top[CARD_CODES];
+    uint64_t drawn[CARD_CODES];
+    uint64_t forced[5];
+    uint64_t turn;
+    uint64_t direction;
+};
+
+inline const ZobristKeys& zobrist_keys() {
+    static const ZobristKeys keys = []() {
+        ZobristKeys out;
+        uint64_t state = 0x5eed0fc0ffee2024ULL;
+        for (int code = 0; code < CARD_CODES; code++) {
+            for (int copies = 0; copies <= MAX_COPIES; copies++) {
+                out.hand[0][code][copies] = copies == 0 ? 0 : splitmix64(state);
+                out.hand[1][code][copies] = copies == 0 ? 0 : splitmix64(state);
+                out.pile[code][copies] = copies == 0 ? 0 : splitmix64(state);
+            }
+            out.top[code] = splitmix64(state);
+            out.drawn[code] = splitmix64(state);
+        }
+        for (int i = 0; i < 5; i++) {
+            out.forced[i] = i == 0 ? 0 : splitmix64(state);
+        }
+        out.turn = splitmix64(state);
+        out.direction = splitmix64(state);
+        return out;
+    }();
+    return keys;
+}
+
+/**
+ * Struct: EndgamePosition
+ * Description:
+ * A two-player position as the solver sees it: both hands, the main deck and
+ * the discard pile as card counts (the order of the main deck is unknown, so
+ * every draw is a chance event weighted by the copies left), the top card with
+ * the colour a wild named, and the state between decisions. Every change goes
+ * through a method that keeps `hash` up to date incrementally.
+ */
+struct EndgamePosition {
+    player hands[2];
+    player pile; // main deck, as a multiset
+    player discard; // discard pile including the top card, wilds without colour
+    card top; // played_card, a wild carries the colour it named
+    int turn;
+    int direction;
+    int forced; // cards the player to move must still draw before deciding
+    bool drawn_pending;
+    card drawn_card;
+    uint64_t hash;
+
+    // Function to read the position of a two-player engine
+
+    static EndgamePosition from_engine(const GameEngine& engine) {
+        EndgamePosition pos;
+        pos.hands[0] = engine.get_player(0);
+        pos.hands[1] = engine.get_player(1);
+        const CardPiles& piles = engine.get_piles();
+        for (int i = 0; i < piles.get_main_size(); i++) {
+            pos.pile.hand_add(piles.main_at(i));
+        }
+        for (int i = 0; i < piles.get_discard_size(); i++) {
+            pos.discard.hand_add(piles.discard_at(i));
+        }
+        pos.top = engine.get_played_card();
+        pos.turn = engine.get_turn();
+        pos.direction = engine.get_turn_flag();
+        pos.forced = 0; // the engine takes forced draws before the turn starts
+        pos.drawn_pending = engine.is_drawn_pending();
+        pos.drawn_card = engine.get_drawn_card();
+        pos.hash = pos.compute_hash();
+        return pos;
+    }
+
+    uint64_t compute_hash() const {
+        const ZobristKeys& keys = zobrist_keys();
+        uint64_t h = keys.top[top.get_code()] ^ keys.forced[forced];
+        for (int code = 0; code < CARD_CODES; code++) {
+            card temp = player::from_code(code);
+            h ^= keys.hand[0][code][hands[0].count(temp)] ^ keys.hand[1][code][hands[1].count(temp)];
+            h ^= keys.pile[code][pile.count(temp)];
+        }
+        if (turn == 1) {
+            h ^= keys.turn;
+        }
+        if (direction < 0) {
+            h ^= keys.direction;
+        }
+        if (drawn_pending) {
+            h ^= keys.drawn[drawn_card.get_code()];
+        }
+        return h;
+    }
+
+    void hand_add(int seat, card temp) {
+        const uint64_t* keys = zobrist_keys().hand[seat][temp.get_code()];
+        int copies = hands[seat].count(temp);
+        hash ^= keys[copies] ^ keys[copies + 1];
+        hands[seat].hand_add(temp);
+    }
+
+    void hand_remove(int seat, card temp) {
+        const uint64_t* keys = zobrist_keys().hand[seat][temp.get_code()];
+        int copies = hands[seat].count(temp);
+        hash ^= keys[copies] ^ keys[copies - 1];
+        hands[seat].hand_remove_card(temp);
+    }
+
+    void pile_remove(card temp) {
+        const uint64_t* keys = zobrist_keys().pile[temp.get_code()];
+        int copies = pile.count(temp);
+        hash ^= keys[copies] ^ keys[copies - 1];
+        pile.hand_remove_card(temp);
+    }
+
+    void set_top(card temp) {
+        hash ^= zobrist_keys().top[top.get_code()] ^ zobrist_keys().top[temp.get_code()];
+        top = temp;
+    }
+
+    void set_turn(int seat) {
+        if (seat != turn) {
+            hash ^= zobrist_keys().turn;
+            turn = seat;
+        }
+    }
+
+    void set_forced(int count) {
+        hash ^= zobrist_keys().forced[forced] ^ zobrist_keys().forced[count];
+        forced = count;
+    }
+
+    void set_drawn(bool pending, card temp) {
+        if (drawn_pending) {
+            hash ^= zobrist_keys().drawn[drawn_card.get_code()];
+        }
+        if (pending) {
+            hash ^= zobrist_keys().drawn[temp.get_code()];
+        }
+        drawn_pending = pending;
+        drawn_card = temp;
+    }
+
+    // Function to put a card on the discard pile and on top
+
+    void play(card temp, COLOR named) {
+        discard.hand_add(temp);
+        if (temp.color() == wild) {
+            temp.set_color(named);
+        }
+        set_top(temp);
+    }
+
+    // Function to shuffle the discard pile, except its top card, back into the main deck
+
+    void recycle() {
+        card top_card = top;
+        if (top_card.number() >= WILD) {
+            top_card.set_color(wild);
+        }
+        discard.hand_remove_card(top_card);
+        for (int code = 0; code < CARD_CODES; code++) {
+            card temp = player::from_code(code);
+            int copies = discard.count(temp);
+            if (copies > 0) {
+                const uint64_t* keys = zobrist_keys().pile[code];
+                int before = pile.count(temp);
+                hash ^= keys[before] ^ keys[before + copies];
+                for (int k = 0; k < copies; k++) {
+                    pile.hand_add(temp);
+                }
+            }
+        }
+        discard = player();
+        discard.hand_add(top_card);
+    }
+
+    // Function to pass the turn on, as GameEngine::end_turn does with two players
+
+    void end_turn(bool played) {
+        int number = top.number();
+        if (!(played && (number == SKIP || number == REVERSE))) {
+            // skip and reverse both give the same player another turn at a table of two
+            set_turn(turn ^ 1);
+        }
+        if (pile.get_size() < RESHUFFLE_THRESHOLD) {
+            recycle();
+        }
+        if (played && number == DRAW_TWO) {
+            set_forced(2);
+        } else if (played && number == WILD_DRAW_FOUR) {
+            set_forced(4);
+        }
+    }
+};
+
+struct SolveResult {
+    double value; // chance that the player to move wins with perfect play from both sides
+    int move; // solver move key of the best move
+    int depth; // plies searched ahead
+    bool proven; // no line was cut short by the depth limit, so value is exact
+    long long nodes;
+    long long tt_probes;
+    long long tt_hits;
+};
+
+/**
+ * Class: EndgameSolver
+ * Description:
+ * Expectimax with alpha-beta cut-offs over a two-player EndgamePosition.
+ * Decision nodes take the best move for the player to move; draws are chance
+ * nodes averaged over every card code left in the main deck, and are pruned
+ * with Star1 (the value of a chance node is bounded by what its remaining
+ * outcomes could still add, since every value lies in [0, 1]). Values are win
+ * probabilities of the player to move, so a child where the other player
+ * moves is searched with the mirrored window and its value mirrored back.
+ *
+ * The search deepens one ply at a time, a ply being a decision or one card
+ * of a forced draw. Nodes whose whole subtree ended in finished games are
+ * stored with TT_PROVEN_DEPTH and reused at any depth; the rest are stored
+ * with the depth they were searched to. A search stops early once its result
+ * is proven. At the depth limit, positions are scored by
+ * the share of cards the opponent still holds.
+ *
+ * Moves are ordered by the transposition table first, then by a static guess:
+ * winning plays, cards that keep the turn, draw penalties, other plays by how
+ * many of their colour remain, and drawing last.
+ *
+ * With more than one thread the search is a lazy SMP: every thread searches
+ * the same root, half of them one depth ahead, and they share only the lock-free
+ * TranspositionTable. Thread 0's result is returned and stops the others.
+ * Thread 0 also watches the time limit; a depth that runs out of time is
+ * thrown away.
+ *
+ * Functionality:
+ * - `solve`: Searches a position to at most max_depth plies or a time limit.
+ * - `to_move`: Turns a solver move key into a Move for the engine.
+ * - `key_of`: Turns an engine Move into a solver move key.
+ */
+class EndgameSolver {
+public:
+
+    EndgameSolver(size_t tt_megabytes, int threads = 1) : tt(tt_megabytes), pool(threads), workers(pool.get_threads()), stop(false), timed(false) {
+    }
+
+    // Function to search root one ply deeper at a time up to max_depth, or until time_ms
+    // milliseconds have passed (0 for no limit); the deepest finished search is returned
+
+    SolveResult solve(const EndgamePosition& root, int max_depth, double time_ms = 0) {
+        if (max_depth > SOLVER_MAX_DEPTH) {
+            max_depth = SOLVER_MAX_DEPTH;
+        }
+        tt.new_search();
+        stop.store(false);
+        timed = time_ms > 0;
+        deadline = std::chrono::steady_clock::now() + std::chrono::microseconds((long long) (time_ms * 1000));
+        SolveResult result = {0.5, KEY_NONE, 0, false, 0, 0, 0};
+        pool.run(pool.get_threads(), [&](int, uint32_t task) {
+            // one task per searcher, a pool thread that runs out of work may steal another's, so go by task
+            int w = task;
+            Worker& worker = workers[w];
+            worker.nodes = 0;
+            worker.tt_probes = 0;
+            worker.tt_hits = 0;
+            worker.timer = w == 0 && timed;
+            for (int depth = 1 + (w & 1); depth <= max_depth && !stop.load(std::memory_order_relaxed); depth++) {
+                long long horizon = worker.horizon;
+                int best = KEY_NONE;
+                double value = search(worker, root, 0, 1, depth, &best);
+                if (w != 0 || stop.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+                result.value = value;
+                result.move = best;
+                result.depth = depth;
+                result.proven = worker.horizon == horizon;
+                if (result.proven) {
+                    break;
+                }
+            }
+            if (w == 0) {
+                stop.store(true, std::memory_order_relaxed);
+            }
+        });
+
+        for (int w = 0; w < pool.get_threads(); w++) {
+            result.nodes += workers[w].nodes;
+            result.tt_probes += workers[w].tt_probes;
+            result.tt_hits += workers[w].tt_hits;
+        }
+        return result;
+    }
+
+    // Function to turn a solver move key into a Move for engine, whose position the key was found in
+
+    static Move to_move(const GameEngine& engine, int key) {
+        if (key == KEY_DRAW || key == KEY_NONE) {
+            return Move(draw_card);
+        }
+        if (key == KEY_PLAY_DRAWN) {
+            return Move(play_drawn);
+        }
+        if (key == KEY_KEEP_DRAWN) {
+            return Move(keep_drawn);
+        }
+        card temp = player::from_code(key >> 2);
+        int index = engine.get_player(engine.get_turn()).index_of(temp);
+        if (temp.color() == wild) {
+            return Move(play_card, index, static_cast<COLOR> ((key & 3) + 1));
+        }
+        return Move(play_card, index);
+    }
+
+    // Function to get the solver move key of an engine move in the engine's current position
+
+    static int key_of(const GameEngine& engine, const Move& move) {
+        if (move.type != play_card) {
+            return move.type == draw_card ? KEY_DRAW : move.type == play_drawn ? KEY_PLAY_DRAWN : KEY_KEEP_DRAWN;
+        }
+        card temp = engine.get_player(engine.get_turn()).peek(move.index);
+        return temp.get_code() * 4 + (temp.color() == wild ? move.color - 1 : 0);
+    }
+
+private:
+
+    struct alignas(64) Worker {
+        long long nodes;
+        long long tt_probes;
+        long long tt_hits;
+        long long horizon; // leaves cut off by the depth limit, or taken from a table entry that was
+        bool timer; // this worker watches the deadline
+
+        Worker() : nodes(0), tt_probes(0), tt_hits(0), horizon(0), timer(false) {
+        }
+    };
+
+    TranspositionTable tt;
+    WorkStealingPool pool;
+    std::vector<Worker> workers;
+    std::atomic<bool> stop;
+    bool timed;
+    std::chrono::steady_clock::time_point deadline;
+
+    // Function to score a position at the depth limit for the player to move
+
+    static double evaluate(const EndgamePosition& pos) {
+        int own = pos.hands[pos.turn].get_size() + pos.forced;
+        int other = pos.hands[pos.turn ^ 1].get_size();
+        return (double) other / (own + other);
+    }
+
+    // Function to search child for the player `seat`, mirroring the window when the other player moves there
+
+    double value_for(Worker& worker, int seat, const EndgamePosition& child, double alpha, double beta, int depth) {
+        if (child.turn == seat) {
+            return search(worker, child, alpha, beta, depth, NULL);
+        }
+        return 1 - search(worker, child, 1 - beta, 1 - alpha, depth, NULL);
+    }
+
+    double search(Worker& worker, const EndgamePosition& pos, double alpha, double beta, int depth, int* best_out) {
+        worker.nodes++;
+        if (worker.timer && (worker.nodes & 4095) == 0 && std::chrono::steady_clock::now() >= deadline) {
+            stop.store(true, std::memory_order_relaxed);
+        }
+        if (stop.load(std::memory_order_relaxed)) {
+            return 0.5;
+        }
+
+        int tt_move = KEY_NONE;
+        TTData entry;
+        worker.tt_probes++;
+        if (tt.probe(pos.hash, entry)) {
+            worker.tt_hits++;
+            tt_move = entry.move;
+            if (entry.depth >= depth && best_out == NULL) {
+                bool cut = entry.bound == tt_exact || (entry.bound == tt_lower && entry.value >= beta) || (entry.bound == tt_upper && entry.value <= alpha);
+                if (cut) {
+                    if (entry.depth != TT_PROVEN_DEPTH) {
+                        worker.horizon++;
+                    }
+                    return entry.value;
+                }
+            }
+        }
+        if (depth == 0) {
+            worker.horizon++;
+            return evaluate(pos);
+        }
+
+        long long horizon = worker.horizon;
+        double original_alpha = alpha;
+        double best;
+        int best_move = KEY_NONE;
+        if (pos.forced > 0) {
+            best = draw_chance(worker, pos, alpha, beta, depth, true);
+        } else {
+            int keys[CARD_CODES * 4 + 3];
+            int n = order_moves(pos, tt_move, keys);
+            best = -1;
+            for (int i = 0; i < n; i++) {
+                double value = apply(worker, pos, keys[i], alpha, beta, depth);
+                if (value > best) {
+                    best = value;
+                    best_move = keys[i];
+                }
+                if (best > alpha) {
+                    alpha = best;
+                }
+                if (alpha >= beta) {
+                    break;
+                }
+            }
+        }
+
+        // values of a stopped search are incomplete and must not reach the table
+        if (stop.load(std::memory_order_relaxed)) {
+            return best;
+        }
+        TT_BOUND bound = best <= original_alpha ? tt_upper : best >= beta ? tt_lower : tt_exact;
+        tt.store(pos.hash, (float) best, worker.horizon == horizon ? TT_PROVEN_DEPTH : depth, bound, best_move);
+        if (best_out != NULL) {
+            *best_out = best_move;
+        }
+        return best;
+    }
+
+    // Function to list the moves of pos into keys, best guess first, and return how many there are
+
+    static int order_moves(const EndgamePosition& pos, int tt_move, int* keys) {
+        if (pos.drawn_pending) {
+            keys[0] = tt_move == KEY_KEEP_DRAWN ? KEY_KEEP_DRAWN : KEY_PLAY_DRAWN;
+            keys[1] = keys[0] == KEY_KEEP_DRAWN ? KEY_PLAY_DRAWN : KEY_KEEP_DRAWN;
+            return 2;
+        }
+
+        const player& hand = pos.hands[pos.turn];
+        int scores[CARD_CODES * 4 + 3];
+        int n = 0;
+        PlayableMask mask = hand.playable_mask(pos.top);
+        for (int word = 0; word < 2; word++) {
+            for (uint64_t bits = mask.bits[word]; bits != 0; bits &= bits - 1) {
+                int code = word * 64 + __builtin_ctzll(bits);
+                card temp = player::from_code(code);
+                int number = temp.number();
+                int score = hand.get_size() == 1 ? 1000 : number == SKIP || number == REVERSE ? 500 : number == WILD_DRAW_FOUR ? 400 : number == DRAW_TWO ? 300 : 0;
+                if (temp.color() == wild) {
+                    for (int col = red; col <= yellow; col++) {
+                        keys[n] = code * 4 + col - 1;
+                        scores[n++] = score + 10 * hand.color_count(static_cast<COLOR> (col));
+                    }
+                } else {
+                    keys[n] = code * 4;
+                    scores[n++] = score + 10 * hand.color_count(temp.color()) + 50;
+                }
+            }
+        }
+        keys[n] = KEY_DRAW;
+        scores[n++] = -1;
+
+        // insertion sort, hands are small
+        for (int i = 0; i < n; i++) {
+            if (keys[i] == tt_move) {
+                scores[i] = 1 << 20;
+            }
+        }
+        for (int i = 1; i < n; i++) {
+            int key = keys[i];
+            int score = scores[i];
+            int j = i - 1;
+            for (; j >= 0 && scores[j] < score; j--) {
+                keys[j + 1] = keys[j];
+                scores[j + 1] = scores[j];
+            }
+            keys[j + 1] = key;
+            scores[j + 1] = score;
+        }
+        return n;
+    }
+
+    // Function to get the value of playing move key in pos, for the player to move
+
+    double apply(Worker& worker, const EndgamePosition& pos, int key, double alpha, double beta, int depth) {
+        if (key == KEY_DRAW) {
+            return draw_chance(worker, pos, alpha, beta, depth, false);
+        }
+
+        EndgamePosition child = pos;
+        if (key == KEY_PLAY_DRAWN) {
+            child.set_drawn(false, card());
+            child.play(pos.drawn_card, wild);
+            child.end_turn(true);
+        } else if (key == KEY_KEEP_DRAWN) {
+            child.set_drawn(false, card());
+            child.hand_add(pos.turn, pos.drawn_card);
+            child.end_turn(false);
+        } else {
+            card temp = player::from_code(key >> 2);
+            child.hand_remove(pos.turn, temp);
+            if (child.hands[pos.turn].get_size() == 0) {
+                return 1;
+            }
+            child.play(temp, static_cast<COLOR> ((key & 3) + 1));
+            child.end_turn(true);
+        }
+        return value_for(worker, pos.turn, child, alpha, beta, depth - 1);
+    }
+
+    // Function to average over every card the player to move could draw: a forced draw when
+    // forced is true, otherwise the draw_card move
+
+    double draw_chance(Worker& worker, const EndgamePosition& pos, double alpha, double beta, int depth, bool forced) {
+        EndgamePosition base = pos;
+        if (base.pile.get_size() == 0) {
+            base.recycle();
+        }
+        if (base.pile.get_size() == 0) {
+            // nothing left anywhere to draw
+            if (forced) {
+                base.set_forced(0);
+                return search(worker, base, alpha, beta, depth, NULL);
+            }
+            base.end_turn(false);
+            return value_for(worker, pos.turn, base, alpha, beta, depth - 1);
+        }
+
+        double total = base.pile.get_size();
+        double sum = 0;
+        double rest = 1;
+        for (int code = 0; code < CARD_CODES; code++) {
+            card temp = player::from_code(code);
+            int copies = base.pile.count(temp);
+            if (copies == 0) {
+                continue;
+            }
+            double p = copies / total;
+            rest -= p;
+
+            EndgamePosition child = base;
+            child.pile_remove(temp);
+            if (forced) {
+                child.hand_add(pos.turn, temp);
+                child.set_forced(pos.forced - 1);
+            } else if (temp == pos.top && temp.color() != wild) {
+                child.set_drawn(true, temp);
+            } else {
+                child.hand_add(pos.turn, temp);
+                child.end_turn(false);
+            }
+
+            // Star1: the window this outcome must beat for the node to leave [alpha, beta]
+            double child_alpha = (alpha - sum - rest) / p;
+            double child_beta = (beta - sum) / p;
+            child_alpha = child_alpha < 0 ? 0 : child_alpha;
+            child_beta = child_beta > 1 ? 1 : child_beta;
+            sum += p * value_for(worker, pos.turn, child, child_alpha, child_beta, depth - 1);
+            if (sum >= beta) {
+                return sum;
+            }
+            if (sum + rest <= alpha) {
+                return sum + rest;
+            }
+        }
+        return sum;
+    }
+};
+
+#endif /* ENDGAME_SOLVER_H */
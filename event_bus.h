@@ -0,0 +1,363 @@
+/*
+ * File:   event_bus.h
+ *
+ * Moves the events of games played on worker threads to observers running on
+ * threads of their own, through lock-free single-producer single-consumer
+ * queues, so that analytics never hold up the game loop.
+ */
+
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "card.h"
+#include "game_events.h"
+#include "seating.h"
+
+#define EVENT_QUEUE_SIZE 65536 // events one queue holds, a power of two
+#define EVENT_BATCH 1024 // events an observer gets from one queue at a time
+#define EVENT_IDLE_US 50 // how long a consumer sleeps when every queue was empty
+
+/**
+ * Class: SpscQueue
+ * Description:
+ * A bounded ring of Size items between exactly one producer thread and one
+ * consumer thread. Each side owns one index and keeps a cached copy of the
+ * other's, on separate cache lines, so a push or a pop only reads the other
+ * side's index when the cached one says the ring is full or empty. Nothing
+ * ever waits: a push onto a full ring fails.
+ *
+ * Functionality:
+ * - `try_push`: Adds an item, returns false when the ring is full (producer only).
+ * - `pop_batch`: Takes up to max items in order (consumer only).
+ */
+template <class T, int Size>
+class SpscQueue {
+    static_assert((Size & (Size - 1)) == 0, "the queue size must be a power of two");
+public:
+
+    SpscQueue() : write_pos(0), cached_read(0), read_pos(0), cached_write(0) {
+    }
+
+    bool try_push(const T& item) {
+        uint64_t pos = write_pos.load(std::memory_order_relaxed);
+        if (pos - cached_read >= (uint64_t) Size) {
+            cached_read = read_pos.load(std::memory_order_acquire);
+            if (pos - cached_read >= (uint64_t) Size) {
+                return false;
+            }
+        }
+        slots[pos & (Size - 1)] = item;
+        write_pos.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    int pop_batch(T* out, int max) {
+        uint64_t pos = read_pos.load(std::memory_order_relaxed);
+        if (cached_write == pos) {
+            cached_write = write_pos.load(std::memory_order_acquire);
+            if (cached_write == pos) {
+                return 0;
+            }
+        }
+        int n = cached_write - pos < (uint64_t) max ? (int) (cached_write - pos) : max;
+        for (int i = 0; i < n; i++) {
+            out[i] = slots[(pos + i) & (Size - 1)];
+        }
+        read_pos.store(pos + n, std::memory_order_release);
+        return n;
+    }
+
+private:
+    alignas(64) std::atomic<uint64_t> write_pos;
+    uint64_t cached_read;
+    alignas(64) std::atomic<uint64_t> read_pos;
+    uint64_t cached_write;
+    alignas(64) T slots[Size];
+};
+
+typedef SpscQueue<GameEvent, EVENT_QUEUE_SIZE> EventQueue;
+
+/**
+ * Class: EventObserver
+ * Description:
+ * Something that wants every event, like statistics, a log or a recording.
+ * An observer runs on its own consumer thread and gets the events in
+ * batches, in order for each producer, interleaved between producers.
+ */
+class EventObserver {
+public:
+
+    virtual ~EventObserver() {
+    }
+
+    virtual void on_events(const GameEvent* events, int n) = 0;
+
+    // Function called on the consumer thread after the last batch
+
+    virtual void on_finish() {
+    }
+};
+
+class EventBus;
+
+/**
+ * Struct: BusSink
+ * Description:
+ * The event sink of an engine that plays on one producer lane of an
+ * EventBus: every event goes into that lane's queue of each observer. When
+ * an observer falls so far behind that its queue is full, the event is
+ * dropped for that observer and counted, and the game goes on.
+ */
+struct BusSink {
+    static constexpr bool enabled = true;
+
+    EventBus* bus;
+    int lane;
+
+    BusSink() : bus(NULL), lane(0) {
+    }
+
+    BusSink(EventBus* bus, int lane) : bus(bus), lane(lane) {
+    }
+
+    void emit(const GameEvent& event);
+};
+
+/**
+ * Class: EventBus
+ * Description:
+ * Connects `producers` game threads to a list of observers. There is one
+ * SpscQueue for every producer and observer pair and one consumer thread per
+ * observer, which drains its queues round-robin in batches of up to
+ * EVENT_BATCH events and sleeps for EVENT_IDLE_US when all were empty. A
+ * producer only ever writes to its own queues, so producers never contend
+ * with each other either.
+ *
+ * Functionality:
+ * - `start`: Starts the consumer threads.
+ * - `sink`: Gets the sink for an engine on a producer lane.
+ * - `stop`: Lets the consumers drain everything left and joins them, after the producers are done.
+ * - `dropped`: Gets how many events were dropped because a queue was full.
+ */
+class EventBus {
+public:
+
+    EventBus(int producers, EventObserver* const* observers, int n_observers) : producers(producers), observers(observers, observers + n_observers), stopping(false) {
+        for (int i = 0; i < producers * n_observers; i++) {
+            queues.push_back(std::unique_ptr<EventQueue>(new EventQueue()));
+        }
+        lanes.resize(producers);
+    }
+
+    ~EventBus() {
+        stop();
+    }
+
+    void start() {
+        stopping.store(false);
+        for (size_t c = 0; c < observers.size(); c++) {
+            consumers.emplace_back([this, c]() {
+                consume(c);
+            });
+        }
+    }
+
+    BusSink sink(int lane) {
+        return BusSink(this, lane);
+    }
+
+    void stop() {
+        stopping.store(true, std::memory_order_release);
+        for (std::thread& consumer : consumers) {
+            consumer.join();
+        }
+        consumers.clear();
+    }
+
+    long long dropped() const {
+        long long total = 0;
+        for (const Lane& lane : lanes) {
+            total += lane.dropped;
+        }
+        return total;
+    }
+
+    int get_producers() const {
+        return producers;
+    }
+
+private:
+
+    friend struct BusSink;
+
+    // what one producer writes besides its queues, on a line of its own
+    struct alignas(64) Lane {
+        long long dropped = 0;
+    };
+
+    int producers;
+    std::vector<EventObserver*> observers;
+    std::vector<std::unique_ptr<EventQueue>> queues; // [observer * producers + producer]
+    std::vector<Lane> lanes;
+    std::vector<std::thread> consumers;
+    std::atomic<bool> stopping;
+
+    void publish(int lane, const GameEvent& event) {
+        for (size_t c = 0; c < observers.size(); c++) {
+            if (!queues[c * producers + lane]->try_push(event)) {
+                lanes[lane].dropped++;
+            }
+        }
+    }
+
+    void consume(int c) {
+        GameEvent batch[EVENT_BATCH];
+        EventObserver* observer = observers[c];
+        for (;;) {
+            // stopping is read before the queues, so whatever was pushed before stop() is still drained
+            bool last_round = stopping.load(std::memory_order_acquire);
+            int taken = 0;
+            for (int p = 0; p < producers; p++) {
+                int n = queues[c * producers + p]->pop_batch(batch, EVENT_BATCH);
+                if (n > 0) {
+                    observer->on_events(batch, n);
+                    taken += n;
+                }
+            }
+            if (taken == 0 && last_round) {
+                break;
+            }
+            if (taken == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(EVENT_IDLE_US));
+            }
+        }
+        observer->on_finish();
+    }
+};
+
+inline void BusSink::emit(const GameEvent& event) {
+    bus->publish(lane, event);
+}
+
+/**
+ * Class: EventTally
+ * Description:
+ * Statistics from the event stream alone: events by type, games started and
+ * won, wins by seat, cards drawn and cards reshuffled.
+ */
+class EventTally : public EventObserver {
+public:
+    long long by_type[event_game_won + 1] = {};
+    long long wins[MAX_SEATS] = {};
+    long long cards_drawn = 0;
+    long long cards_reshuffled = 0;
+
+    void on_events(const GameEvent* events, int n) override {
+        for (int i = 0; i < n; i++) {
+            const GameEvent& event = events[i];
+            by_type[event.type]++;
+            if (event.type == event_game_won) {
+                wins[event.seat]++;
+            } else if (event.type == event_cards_drawn) {
+                cards_drawn += event.count;
+            } else if (event.type == event_reshuffled) {
+                cards_reshuffled += event.count;
+            }
+        }
+    }
+};
+
+/**
+ * Class: EventLog
+ * Description:
+ * Writes every event as one line of text. A batch is formatted into one
+ * string and written with a single call.
+ */
+class EventLog : public EventObserver {
+public:
+
+    explicit EventLog(std::ostream& out) : out(out) {
+    }
+
+    void on_events(const GameEvent* events, int n) override {
+        text.clear();
+        for (int i = 0; i < n; i++) {
+            const GameEvent& event = events[i];
+            text += std::to_string(event.game);
+            text += ' ';
+            text += std::to_string(event.turn);
+            text += " PLAYER ";
+            text += std::to_string(event.seat + 1);
+            switch (event.type) {
+                case event_game_started:
+                    text += " starts, players: " + std::to_string(event.count);
+                    break;
+                case event_card_played:
+                    text += " played ";
+                    text.append(CARD_NAMES[event.value].text, CARD_NAMES[event.value].length);
+                    break;
+                case event_cards_drawn:
+                    text += " drew " + std::to_string(event.count);
+                    break;
+                case event_color_chosen:
+                    text += " chose ";
+                    text += color_name(event.value);
+                    break;
+                case event_reshuffled:
+                    text += " reshuffled " + std::to_string(event.count);
+                    break;
+                case event_game_won:
+                    text += " has won the game.";
+                    break;
+            }
+            text += '\n';
+        }
+        out.write(text.data(), text.size());
+    }
+
+    void on_finish() override {
+        out.flush();
+    }
+
+private:
+    std::ostream& out;
+    std::string text;
+
+    static const char* color_name(int col) {
+        static const char* names[5] = {"wild", "red", "green", "blue", "yellow"};
+        return names[col];
+    }
+};
+
+/**
+ * Class: EventRecorder
+ * Description:
+ * Writes the raw 16-byte events, batch by batch, for tools that replay them later.
+ */
+class EventRecorder : public EventObserver {
+public:
+
+    explicit EventRecorder(std::ostream& out) : out(out) {
+    }
+
+    void on_events(const GameEvent* events, int n) override {
+        out.write((const char*) events, (std::streamsize) n * sizeof (GameEvent));
+    }
+
+    void on_finish() override {
+        out.flush();
+    }
+
+private:
+    std::ostream& out;
+};
+
+#endif /* EVENT_BUS_H */
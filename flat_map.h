@@ -0,0 +1,245 @@
+/*
+ * File:   flat_map.h
+ *
+ * Open-addressing hash map for integer ids (connections, tables, players),
+ * with every entry in one flat array instead of a node per entry.
+ */
+
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define FLAT_MAP_MIN_CAPACITY 8 // slots of an empty map, a power of two
+#define FLAT_MAP_MAX_PROBE 255 // longest probe sequence a slot may record, a longer one grows the table
+
+// Function to get the home slot of an id in a table of 2^bits slots by Fibonacci hashing: the top bits of the id
+// times 2^64 / golden ratio depend on every bit of the id, so ids that are multiples of a power of two, like
+// pointers, spread over all slots, and consecutive ids land about as far apart as the table allows
+
+inline size_t home_slot(uint64_t id, int bits) {
+    return (id * 0x9e3779b97f4a7c15ULL) >> (64 - bits);
+}
+
+/**
+ * Class: FlatMap
+ * Description:
+ * A Robin Hood hash table from integer keys to values. The slots are one
+ * array of key and value pairs plus one byte per slot with the distance of its
+ * entry from the slot its hash points at (0 for an empty slot). An insert
+ * takes the slot of any entry that is closer to home than the new one and
+ * moves that entry on, so probe sequences stay short and a lookup stops as
+ * soon as it meets an entry closer to home than the key would be. Erasing
+ * shifts the following entries back instead of leaving tombstones. The table
+ * doubles when it would be more than 7/8 full.
+ *
+ * An insert or erase may move entries, so pointers to values stay valid only
+ * until the next change; keep the objects themselves behind unique_ptr when
+ * they must stay put, as GameServer does.
+ *
+ * Functionality:
+ * - `find`: Gets a pointer to the value of a key, or NULL.
+ * - `operator[]`: Gets the value of a key, inserting a default value if it is missing.
+ * - `erase`: Removes a key, returns whether it was there.
+ * - `reserve`: Grows the table to hold n entries without growing again.
+ * - `size` / `empty` / `clear`: The usual.
+ * - `begin` / `end`: Iterates over the entries, in no particular order, as `entry.key` and `entry.value`.
+ */
+template <class Key, class Value>
+class FlatMap {
+    static_assert(std::is_integral<Key>::value, "FlatMap keys are integer ids");
+public:
+
+    struct Entry {
+        Key key;
+        Value value;
+    };
+
+    class iterator {
+    public:
+
+        iterator(FlatMap* map, size_t pos) : map(map), pos(pos) {
+            skip();
+        }
+
+        Entry& operator*() const {
+            return map->slots[pos];
+        }
+
+        Entry* operator->() const {
+            return &map->slots[pos];
+        }
+
+        iterator& operator++() {
+            pos++;
+            skip();
+            return *this;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return pos != other.pos;
+        }
+
+    private:
+        FlatMap* map;
+        size_t pos;
+
+        void skip() {
+            while (pos < map->slots.size() && map->distances[pos] == 0) {
+                pos++;
+            }
+        }
+    };
+
+    FlatMap() : count(0), bits(0) {
+        allocate(FLAT_MAP_MIN_CAPACITY);
+    }
+
+    Value* find(Key key) {
+        size_t mask = slots.size() - 1;
+        size_t pos = home_slot(key, bits);
+        for (int distance = 1; distances[pos] >= distance; distance++) {
+            if (slots[pos].key == key) {
+                return &slots[pos].value;
+            }
+            pos = (pos + 1) & mask;
+        }
+        return NULL;
+    }
+
+    const Value* find(Key key) const {
+        return const_cast<FlatMap*> (this)->find(key);
+    }
+
+    Value& operator[](Key key) {
+        Value* found = find(key);
+        if (found != NULL) {
+            return *found;
+        }
+        if ((count + 1) * 8 > slots.size() * 7) {
+            grow(slots.size() * 2);
+        }
+        count++;
+        Value* placed = place(Entry{key, Value()});
+        // NULL when the table had to grow on the way, which moved everything
+        return placed != NULL ? *placed : *find(key);
+    }
+
+    bool erase(Key key) {
+        size_t mask = slots.size() - 1;
+        size_t pos = home_slot(key, bits);
+        for (int distance = 1; distances[pos] >= distance; distance++) {
+            if (slots[pos].key == key) {
+                // shift the entries after it one slot back, until one that is home or an empty slot
+                size_t next = (pos + 1) & mask;
+                while (distances[next] > 1) {
+                    slots[pos] = std::move(slots[next]);
+                    distances[pos] = distances[next] - 1;
+                    pos = next;
+                    next = (next + 1) & mask;
+                }
+                slots[pos] = Entry();
+                distances[pos] = 0;
+                count--;
+                return true;
+            }
+            pos = (pos + 1) & mask;
+        }
+        return false;
+    }
+
+    void reserve(size_t n) {
+        size_t capacity = slots.size();
+        while (n * 8 > capacity * 7) {
+            capacity *= 2;
+        }
+        if (capacity > slots.size()) {
+            grow(capacity);
+        }
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    void clear() {
+        count = 0;
+        allocate(FLAT_MAP_MIN_CAPACITY);
+    }
+
+    iterator begin() {
+        return iterator(this, 0);
+    }
+
+    iterator end() {
+        return iterator(this, slots.size());
+    }
+
+private:
+    size_t count;
+    int bits; // log2 of the number of slots
+    std::vector<Entry> slots;
+    std::vector<uint8_t> distances; // 1 + how far each entry sits past its home slot, 0 for an empty slot
+
+    void allocate(size_t capacity) {
+        for (bits = 0; ((size_t) 1 << bits) < capacity; bits++) {
+        }
+        slots.clear();
+        slots.resize(capacity);
+        distances.assign(capacity, 0);
+    }
+
+    void grow(size_t capacity) {
+        std::vector<Entry> old_slots = std::move(slots);
+        std::vector<uint8_t> old_distances = std::move(distances);
+        allocate(capacity);
+        for (size_t i = 0; i < old_slots.size(); i++) {
+            if (old_distances[i] != 0) {
+                place(std::move(old_slots[i]));
+            }
+        }
+    }
+
+    // Function to put an entry whose key is not in the table yet into it, returns where its value ended up or
+    // NULL if the table grew meanwhile
+
+    Value* place(Entry entry) {
+        size_t mask = slots.size() - 1;
+        size_t pos = home_slot(entry.key, bits);
+        Value* placed = NULL;
+        for (int distance = 1;; distance++) {
+            if (distance > FLAT_MAP_MAX_PROBE) {
+                // the entry in hand (the new one or one it displaced) goes into a table twice the size
+                grow(slots.size() * 2);
+                place(std::move(entry));
+                return NULL;
+            }
+            if (distances[pos] == 0) {
+                slots[pos] = std::move(entry);
+                distances[pos] = distance;
+                return placed != NULL ? placed : &slots[pos].value;
+            }
+            if (distances[pos] < distance) {
+                // the resident is closer to home, the entry in hand takes its slot and the resident moves on
+                std::swap(slots[pos], entry);
+                int resident = distances[pos];
+                distances[pos] = distance;
+                distance = resident;
+                if (placed == NULL) {
+                    placed = &slots[pos].value;
+                }
+            }
+            pos = (pos + 1) & mask;
+        }
+    }
+};
+
+#endif /* FLAT_MAP_H */
@@ -0,0 +1,906 @@
+/*
+ * File:   game_engine.h
+ *
+ * Headless UNO rules engine. All of the game state that used to live on the
+ * stack of main() is owned by GameEngine, and the game advances one decision
+ * at a time through step(). Nothing in here reads from cin or writes to cout,
+ * so the same rules drive both the interactive game and batch simulation.
+ */
+
+#ifndef GAME_ENGINE_H
+#define GAME_ENGINE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "card.h"
+#include "card_piles.h"
+#include "game_events.h"
+#include "game_state.h"
+#include "instrumentation.h"
+#include "player.h"
+#include "rng.h"
+#include "rules.h"
+#include "seating.h"
+
+#define MIN_PLAYERS 2
+#define MAX_PLAYERS MAX_SEATS
+#define STARTING_HAND 7
+#define RESHUFFLE_THRESHOLD 10
+#define MAX_TURNS 10000
+
+enum MOVE_TYPE {
+    play_card, // play the card at `index` in the hand, `color` is the choice for a wild
+    draw_card, // draw one card from the main deck
+    play_drawn, // play the card that was just drawn
+    keep_drawn // keep the card that was just drawn
+};
+
+/**
+ * Struct: Move
+ * Description:
+ * One decision of the player whose turn it is. Drawing a card that can be
+ * played right away is a two step decision: `draw_card`, followed by either
+ * `play_drawn` or `keep_drawn`.
+ */
+struct Move {
+    MOVE_TYPE type;
+    int index;
+    COLOR color;
+
+    Move() : type(draw_card), index(-1), color(wild) {
+
+    }
+
+    Move(MOVE_TYPE t, int i = -1, COLOR c = wild) : type(t), index(i), color(c) {
+
+    }
+
+    bool operator==(const Move& other) const {
+        return type == other.type && index == other.index && color == other.color;
+    }
+};
+
+enum STEP_RESULT {
+    step_ok, step_invalid_index, step_not_playable, step_invalid_color, step_invalid_move, step_game_over
+};
+
+/**
+ * Class: BasicEngine
+ * Description:
+ * The `BasicEngine` class holds one game of UNO: the main deck, the discard
+ * pile (`temp_deck`), the players, the card on top of the pile and whose turn
+ * it is. `GameEngine` is the engine for StandardRules, the rules the
+ * interactive game always used:
+ * - Draw-2 and Draw-4 make the next player draw at the start of their turn.
+ * - Skip jumps over the next player, reverse flips the direction (and acts as
+ *   a skip with two players).
+ * - A drawn card may be played right away if it matches and is not wild.
+ * - Tables of up to MAX_PLAYERS seats are supported; when the decks
+ *   (Rules::decks of them) cannot deal seven cards to everybody, every
+ *   player gets the same smaller hand.
+ * - When fewer than RESHUFFLE_THRESHOLD cards are left in the main deck, the
+ *   discard pile (except its top card) is shuffled back into it.
+ *
+ * Any other RuleSet adds house rules on top (see rules.h). Each one is an
+ * `if constexpr` in the few places it changes, so every rule set is its own
+ * engine and GameEngine compiles to exactly the code it had before.
+ *
+ * Events is where the engine reports what happens, as GameEvents (see
+ * game_events.h). GameEngine reports to NoEvents, which compiles every
+ * report away; an engine on a BusSink hands them to an EventBus.
+ *
+ * Functionality:
+ * - `new_game`: Shuffles, deals and flips the starting card from a seed.
+ * - `legal_moves`: Lists every move the current player may make.
+ * - `step`: Applies one move and advances the turn.
+ * - `snapshot`: Takes an immutable GameSnapshot of the current position.
+ * - `restore`: Puts the engine back at a snapshot.
+ * - `copy_state`: Copies the position of another engine without allocating.
+ * - `determinize`: Redeals the cards one seat cannot see, for search.
+ * - `playable_mask`: Gets the cards of the current player that may be played now.
+ * - `get_events`: Gets the event sink, to connect it before new_game.
+ *
+ * Both piles share one ring of deck_cards cards inside the engine (see
+ * BasicCardPiles), so recycling the discard pile shuffles it in place. Once an
+ * engine exists, playing game after game never calls the global allocator.
+ */
+template <class Rules, class Events = NoEvents>
+class BasicEngine {
+public:
+
+    // every card of the game, Rules::decks decks of DECK_SIZE
+    static constexpr int deck_cards = Rules::decks * DECK_SIZE;
+
+    typedef BasicCardPiles<deck_cards> Piles;
+
+    BasicEngine() {
+        amount_players = 0;
+        force_draw_bool = false;
+        drawn_pending = false;
+        forced_draw = 0;
+        stack = 0;
+        winner = -1;
+        turn_count = 0;
+        reshuffles = 0;
+        cards_drawn = 0;
+        game_id = 0;
+        hands_dirty = 0;
+        main_low = 0;
+        temp_low = 0;
+    }
+
+    // Function to set up a new game for amount_players players, fully determined by seed
+
+    void new_game(int amount_players, uint64_t seed) {
+        INSTR_PHASE(phase_deal);
+        this->amount_players = amount_players;
+        rng.seed(seed);
+
+        for (int i = 0; i < amount_players; i++) {
+            play_array[i] = player();
+        }
+
+        /* creating deck */
+        piles.create();
+        piles.shuffle(rng);
+        /* distributing 7 starting cards to each player, fewer at tables too large for the decks */
+        int hand_size = starting_hand(amount_players);
+        for (int i = 0; i < amount_players; i++) {
+            for (int k = 0; k < hand_size; k++) {
+                play_array[i].hand_add(piles.draw());
+            }
+        }
+        /* create the first starting card, wild cards go straight to the discard pile */
+        card temp_card = piles.draw();
+        while (temp_card.color() == wild) {
+            piles.discard(temp_card);
+            temp_card = piles.draw();
+        }
+        piles.discard(temp_card);
+        played_card = temp_card;
+
+        /* randomize who starts first */
+        seating.build(amount_players, rng.bounded(amount_players));
+        force_draw_bool = false;
+        drawn_pending = false;
+        forced_draw = 0;
+        stack = 0;
+        winner = -1;
+        turn_count = 0;
+        reshuffles = 0;
+        cards_drawn = 0;
+        game_id = seed;
+
+        // nothing is shared with snapshots of an earlier game
+        last_snapshot = GameSnapshot();
+        hands_dirty = ~0ULL;
+        main_low = 0;
+        temp_low = 0;
+        emit(event_game_started, seating.get_current(), 0, amount_players);
+    }
+
+    // Function to list the legal moves of the current player into out
+
+    void legal_moves(std::vector<Move>& out) const {
+        out.clear();
+        if (winner >= 0) {
+            return;
+        }
+        if (drawn_pending) {
+            out.push_back(Move(play_drawn));
+            out.push_back(Move(keep_drawn));
+            return;
+        }
+
+        // one move per distinct playable card, at the position of its first copy
+        const player& curr_player = play_array[seating.get_current()];
+        PlayableMask mask = playable_mask();
+        for (int word = 0; word < 2; word++) {
+            for (uint64_t bits = mask.bits[word]; bits != 0; bits &= bits - 1) {
+                card temp = player::from_code(word * 64 + __builtin_ctzll(bits));
+                int index = curr_player.index_of(temp);
+                if (temp.color() == wild) {
+                    for (int col = red; col <= yellow; col++) {
+                        out.push_back(Move(play_card, index, static_cast<COLOR> (col)));
+                    }
+                } else {
+                    out.push_back(Move(play_card, index));
+                }
+            }
+        }
+        out.push_back(Move(draw_card));
+    }
+
+    std::vector<Move> legal_moves() const {
+        std::vector<Move> out;
+        legal_moves(out);
+        return out;
+    }
+
+    // Function to apply a move of the current player, the state is untouched unless step_ok is returned
+
+    STEP_RESULT step(const Move& move) {
+        INSTR_PHASE(phase_apply);
+        if (winner >= 0) {
+            return step_game_over;
+        }
+
+        player* curr_player = &play_array[seating.get_current()];
+
+        if (drawn_pending) {
+            if (move.type == play_drawn) {
+                drawn_pending = false;
+                play(drawn_card, seating.get_current());
+            } else if (move.type == keep_drawn) {
+                drawn_pending = false;
+                curr_player->hand_add(drawn_card);
+                mark_hand(seating.get_current());
+            } else {
+                return invalid(step_invalid_move);
+            }
+            if (move.type == play_drawn) {
+                finish_play();
+            } else {
+                end_turn();
+            }
+            return step_ok;
+        }
+
+        if constexpr (Rules::stacking) {
+            // the penalty is taken at once and the turn goes on as after any forced draw
+            if (stack > 0 && move.type == draw_card) {
+                card temp_card;
+                for (forced_draw = 0; forced_draw < stack && draw(temp_card); forced_draw++) {
+                    curr_player->hand_add(temp_card);
+                }
+                mark_hand(seating.get_current());
+                emit(event_cards_drawn, seating.get_current(), 0, forced_draw);
+                stack = 0;
+                return step_ok;
+            }
+        }
+
+        if constexpr (Rules::draw_until_playable) {
+            if (move.type == draw_card) {
+                card draw_temp;
+                int drawn = 0;
+                while (draw(draw_temp)) {
+                    drawn_card = draw_temp;
+                    drawn++;
+                    if (draw_temp == played_card && draw_temp.color() != wild) {
+                        drawn_pending = true;
+                        emit(event_cards_drawn, seating.get_current(), 0, drawn);
+                        return step_ok;
+                    }
+                    curr_player->hand_add(draw_temp);
+                    mark_hand(seating.get_current());
+                    if (draw_temp == played_card) {
+                        break;
+                    }
+                }
+                emit(event_cards_drawn, seating.get_current(), 0, drawn);
+                end_turn();
+                return step_ok;
+            }
+        }
+
+        if (move.type == draw_card) {
+            card draw_temp;
+            if (draw(draw_temp)) {
+                drawn_card = draw_temp;
+                emit(event_cards_drawn, seating.get_current(), 0, 1);
+                if (draw_temp == played_card && draw_temp.color() != wild) {
+                    // the player has to decide whether to play the drawn card
+                    drawn_pending = true;
+                    return step_ok;
+                }
+                curr_player->hand_add(draw_temp);
+                mark_hand(seating.get_current());
+            }
+            end_turn();
+            return step_ok;
+        }
+
+        if (move.type != play_card) {
+            return invalid(step_invalid_move);
+        }
+        if (move.index < 0 || move.index >= curr_player->get_size()) {
+            return invalid(step_invalid_index);
+        }
+        card temp = curr_player->peek(move.index);
+        if (temp != played_card) {
+            return invalid(step_not_playable);
+        }
+        if constexpr (Rules::stacking) {
+            if (stack > 0 && temp.number() != played_card.number()) {
+                return invalid(step_not_playable);
+            }
+        }
+        if (temp.color() == wild && (move.color < red || move.color > yellow)) {
+            return invalid(step_invalid_color);
+        }
+
+        curr_player->hand_remove(move.index);
+        mark_hand(seating.get_current());
+        play(temp, seating.get_current());
+        if (temp.color() == wild) {
+            played_card.set_color(move.color);
+            emit(event_color_chosen, seating.get_current(), move.color);
+        }
+        if (curr_player->get_size() == 0) {
+            winner = seating.get_current();
+            turn_count++;
+            INSTR_COUNT(counter_turns);
+            emit(event_game_won, winner);
+            return step_ok;
+        }
+        finish_play();
+        return step_ok;
+    }
+
+    // Function to take a snapshot of the current position. Only the hands and pile cards that
+    // changed since the engine's previous snapshot (or restore) are read and copied, the rest is shared.
+
+    GameSnapshot snapshot() {
+        std::shared_ptr<SnapshotNode> node = std::make_shared<SnapshotNode>();
+        node->amount_players = amount_players;
+        node->played_card = played_card;
+        node->seating = seating;
+        node->force_draw_bool = force_draw_bool;
+        node->drawn_pending = drawn_pending;
+        node->drawn_card = drawn_card;
+        node->forced_draw = forced_draw;
+        node->stack = stack;
+        node->winner = winner;
+        node->turn_count = turn_count;
+        node->reshuffles = reshuffles;
+        node->cards_drawn = cards_drawn;
+        node->rng = rng;
+
+        const SnapshotNode* last = last_snapshot.empty() ? NULL : &last_snapshot.get_node();
+        node->hands.resize(amount_players);
+        for (int i = 0; i < amount_players; i++) {
+            if (last != NULL && ((hands_dirty >> i) & 1) == 0) {
+                node->hands[i] = last->hands[i];
+            } else {
+                node->hands[i] = std::make_shared<const player>(play_array[i]);
+            }
+        }
+        node->main_pile = build_pile(last ? last->main_pile : NULL, main_low, [this](int pos) {
+            return piles.main_at(pos);
+        }, piles.get_main_size());
+        node->temp_pile = build_pile(last ? last->temp_pile : NULL, temp_low, [this](int pos) {
+            return piles.discard_at(pos);
+        }, piles.get_discard_size());
+
+        last_snapshot = GameSnapshot(node);
+        hands_dirty = 0;
+        main_low = piles.get_main_size();
+        temp_low = piles.get_discard_size();
+        return last_snapshot;
+    }
+
+    // Function to put the engine back at a snapshot taken from this or any other engine
+
+    void restore(const GameSnapshot& snapshot) {
+        const SnapshotNode& node = snapshot.get_node();
+        amount_players = node.amount_players;
+        played_card = node.played_card;
+        seating = node.seating;
+        force_draw_bool = node.force_draw_bool;
+        drawn_pending = node.drawn_pending;
+        drawn_card = node.drawn_card;
+        forced_draw = node.forced_draw;
+        stack = node.stack;
+        winner = node.winner;
+        turn_count = node.turn_count;
+        reshuffles = node.reshuffles;
+        cards_drawn = node.cards_drawn;
+        rng = node.rng;
+
+        for (int i = 0; i < amount_players; i++) {
+            play_array[i] = *node.hands[i];
+        }
+        card main_cards[deck_cards];
+        card discard_cards[deck_cards];
+        read_pile(node.main_pile, main_cards);
+        read_pile(node.temp_pile, discard_cards);
+        piles.assign(main_cards, pile_size(node.main_pile), discard_cards, pile_size(node.temp_pile));
+
+        last_snapshot = snapshot;
+        hands_dirty = 0;
+        main_low = piles.get_main_size();
+        temp_low = piles.get_discard_size();
+    }
+
+    // Function to copy the position of other into this engine, reusing this engine's storage
+
+    void copy_state(const BasicEngine& other) {
+        amount_players = other.amount_players;
+        played_card = other.played_card;
+        seating = other.seating;
+        force_draw_bool = other.force_draw_bool;
+        drawn_pending = other.drawn_pending;
+        drawn_card = other.drawn_card;
+        forced_draw = other.forced_draw;
+        stack = other.stack;
+        winner = other.winner;
+        turn_count = other.turn_count;
+        reshuffles = other.reshuffles;
+        cards_drawn = other.cards_drawn;
+        game_id = other.game_id;
+        rng = other.rng;
+        for (int i = 0; i < amount_players; i++) {
+            play_array[i] = other.play_array[i];
+        }
+        piles = other.piles;
+
+        last_snapshot = GameSnapshot();
+        hands_dirty = ~0ULL;
+        main_low = 0;
+        temp_low = 0;
+    }
+
+    // Function to replace everything observer cannot see with a random deal that agrees with what
+    // observer knows: its own hand, the discard pile and how many cards every other hand and the
+    // main deck hold. Future reshuffles are randomized as well.
+
+    void determinize(int observer, Rng& sample) {
+        card pool[deck_cards];
+        int sizes[MAX_PLAYERS];
+        int n = 0;
+        for (int i = 0; i < amount_players; i++) {
+            if (i == observer) {
+                continue;
+            }
+            sizes[i] = play_array[i].get_size();
+            n += play_array[i].get_cards(pool + n);
+            play_array[i] = player();
+        }
+        n += piles.get_main(pool + n);
+
+        for (int i = n - 1; i > 0; i--) {
+            int pos = sample.bounded(i + 1);
+            card temp_card = pool[i];
+            pool[i] = pool[pos];
+            pool[pos] = temp_card;
+        }
+
+        // hand sizes are still public, so refill every other seat to the size it had
+        int next = 0;
+        for (int i = 0; i < amount_players; i++) {
+            if (i == observer) {
+                continue;
+            }
+            for (int k = sizes[i]; k > 0; k--) {
+                play_array[i].hand_add(pool[next++]);
+            }
+        }
+        piles.assign_main(pool + next, n - next);
+        rng.seed(sample.next());
+
+        hands_dirty = ~0ULL;
+        main_low = 0;
+        temp_low = 0;
+    }
+
+    bool is_over() const {
+        return winner >= 0;
+    }
+
+    int get_winner() const {
+        return winner;
+    }
+
+    int get_turn() const {
+        return seating.get_current();
+    }
+
+    // 1 for clockwise, -1 for counter clockwise
+
+    int get_turn_flag() const {
+        return seating.get_direction();
+    }
+
+    const Seating& get_seating() const {
+        return seating;
+    }
+
+    // Cards dealt to every player at the start of a game with amount_players players
+
+    static int starting_hand(int amount_players) {
+        int hand_size = (deck_cards - 2 * RESHUFFLE_THRESHOLD) / amount_players;
+        return hand_size < STARTING_HAND ? hand_size : STARTING_HAND;
+    }
+
+    int get_turn_count() const {
+        return turn_count;
+    }
+
+    // Number of times the discard pile went back into the main deck this game
+
+    int get_reshuffles() const {
+        return reshuffles;
+    }
+
+    // Number of cards drawn from the main deck since the deal, forced draws included
+
+    int get_cards_drawn() const {
+        return cards_drawn;
+    }
+
+    int get_amount_players() const {
+        return amount_players;
+    }
+
+    card get_played_card() const {
+        return played_card;
+    }
+
+    // Number of cards the current player was forced to draw at the start of the turn
+
+    int get_forced_draw() const {
+        return forced_draw;
+    }
+
+    // Cards the current player takes with draw_card while Draw cards are stacked on them
+
+    int get_stack() const {
+        return stack;
+    }
+
+    // The cards of the current player that may be played on the card on top of the pile now
+
+    PlayableMask playable_mask() const {
+        PlayableMask mask = play_array[seating.get_current()].playable_mask(played_card);
+        if constexpr (Rules::stacking) {
+            if (stack > 0) {
+                // only a Draw card of the same kind can be stacked
+                PlayableMask same = played_card.number() == DRAW_TWO ? DRAW_TWO_CARDS : DRAW_FOUR_CARDS;
+                mask.bits[0] &= same.bits[0];
+                mask.bits[1] &= same.bits[1];
+            }
+        }
+        return mask;
+    }
+
+    bool is_drawn_pending() const {
+        return drawn_pending;
+    }
+
+    // The card the current (or, once the turn ended, the previous) player drew with draw_card
+
+    card get_drawn_card() const {
+        return drawn_card;
+    }
+
+    const player& get_player(int i) const {
+        return play_array[i];
+    }
+
+    player* get_players() {
+        return play_array;
+    }
+
+    Events& get_events() {
+        return events;
+    }
+
+    // The main deck and the discard pile (temp_deck)
+
+    const Piles& get_piles() const {
+        return piles;
+    }
+
+private:
+    Piles piles; // the main deck, and the discard pile where all cards that are played go
+    player play_array[MAX_PLAYERS];
+    int amount_players;
+    card played_card;
+    Seating seating; // whose turn it is and the direction of play
+    bool force_draw_bool; // an action card was just played
+    bool drawn_pending;
+    card drawn_card;
+    int forced_draw;
+    int stack; // penalty waiting for the current player, only with Rules::stacking
+    int winner;
+    int turn_count;
+    int reshuffles;
+    int cards_drawn;
+    uint64_t game_id; // the seed of the game, stamped on its events
+    Rng rng;
+    Events events;
+
+    static constexpr PlayableMask DRAW_TWO_CARDS = number_mask(DRAW_TWO);
+    static constexpr PlayableMask DRAW_FOUR_CARDS = number_mask(WILD_DRAW_FOUR);
+    // what changed since last_snapshot: one bit per hand, and how far each pile shrank
+    GameSnapshot last_snapshot;
+    uint64_t hands_dirty;
+    int main_low;
+    int temp_low;
+
+    void mark_hand(int seat) {
+        hands_dirty |= 1ULL << seat;
+    }
+
+    STEP_RESULT invalid(STEP_RESULT result) {
+        INSTR_COUNT(counter_invalid_moves);
+        return result;
+    }
+
+    // Function to report an event to Events, nothing is left of it with NoEvents
+
+    void emit(EVENT_TYPE type, int seat, int value = 0, int count = 0) {
+        static_assert(MAX_SEATS <= 64 && CARD_CODES <= 128 && event_game_won < 8, "the fields of GameEvent are too narrow");
+        if constexpr (Events::enabled) {
+            GameEvent event = {game_id, turn_count, (uint16_t) type, (uint16_t) seat, (uint16_t) value, (uint16_t) count};
+            events.emit(event);
+        }
+    }
+
+    // Function to put the card seat played on the discard pile
+
+    void play(card temp, int seat) {
+        emit(event_card_played, seat, temp.get_code());
+        piles.discard(temp);
+        played_card = temp;
+        if (played_card.number() >= DRAW_TWO && played_card.number() <= WILD_DRAW_FOUR) {
+            force_draw_bool = true;
+        }
+    }
+
+    // Function to draw a card from the main deck, recycling the discard pile if it ran dry
+
+    bool draw(card& out) {
+        if (piles.is_main_empty()) {
+            recycle();
+            if (piles.is_main_empty()) {
+                return false;
+            }
+        }
+        out = piles.draw();
+        cards_drawn++;
+        INSTR_COUNT(counter_draws);
+        if (piles.get_main_size() < main_low) {
+            main_low = piles.get_main_size();
+        }
+        return true;
+    }
+
+    // Function to shuffle the discard pile (except its top card) back into the main deck
+
+    void recycle() {
+        INSTR_PHASE(phase_reshuffle);
+        INSTR_COUNT(counter_reshuffles);
+        emit(event_reshuffled, seating.get_current(), 0, piles.get_discard_size() > 0 ? piles.get_discard_size() - 1 : 0);
+        piles.recycle(rng);
+        reshuffles++;
+        main_low = 0;
+        temp_low = 0;
+    }
+
+    // Function to let the house rules react to the card just played, then pass the turn on
+
+    void finish_play() {
+        if constexpr (Rules::seven_zero) {
+            seven_zero();
+        }
+        if constexpr (Rules::jump_in) {
+            if (jump_in()) {
+                return;
+            }
+        }
+        end_turn();
+    }
+
+    void seven_zero() {
+        int current = seating.get_current();
+        if (played_card.number() == 7) {
+            int target = seating.peek_next();
+            for (int step = 2; step < amount_players; step++) {
+                int seat = seating.peek_next(step);
+                if (play_array[seat].get_size() < play_array[target].get_size()) {
+                    target = seat;
+                }
+            }
+            std::swap(play_array[current], play_array[target]);
+            mark_hand(current);
+            mark_hand(target);
+        } else if (played_card.number() == 0) {
+            // seat s takes the hand of the seat before it in the direction of play
+            if (seating.get_direction() > 0) {
+                std::rotate(play_array, play_array + amount_players - 1, play_array + amount_players);
+            } else {
+                std::rotate(play_array, play_array + 1, play_array + amount_players);
+            }
+            hands_dirty = ~0ULL;
+        }
+    }
+
+    // Function to let the nearest player holding a copy of the card just played play it, returns true if that won
+
+    bool jump_in() {
+        if (played_card.color() == wild) {
+            return false;
+        }
+        for (int step = 1; step < amount_players; step++) {
+            int seat = seating.peek_next(step);
+            int index = play_array[seat].index_of(played_card);
+            if (index < 0) {
+                continue;
+            }
+            card temp = played_card;
+            play_array[seat].hand_remove(index);
+            mark_hand(seat);
+            play(temp, seat);
+            seating.jump_to(seat);
+            if (play_array[seat].get_size() == 0) {
+                winner = seat;
+                turn_count++;
+                INSTR_COUNT(counter_turns);
+                emit(event_game_won, winner);
+                return true;
+            }
+            if constexpr (Rules::seven_zero) {
+                seven_zero();
+            }
+            return false;
+        }
+        return false;
+    }
+
+    void end_turn() {
+        turn_count++;
+        INSTR_COUNT(counter_turns);
+
+        // check for action cards that influence the turn here
+        // skip case
+        if (played_card.number() == SKIP && force_draw_bool == true) {
+            seating.skip();
+        }// reverse case
+        else if (played_card.number() == REVERSE && force_draw_bool == true) {
+            // if only two players, behaves like a skip card
+            if (amount_players == 2) {
+                seating.skip();
+            } else {
+                // changes the rotation of game (from CW to CCW or vice versa)
+                seating.reverse();
+                seating.next();
+            }
+        }// for other cards
+        else {
+            seating.next();
+        }
+
+        // when main deck is running out of cards
+        if (piles.get_main_size() < RESHUFFLE_THRESHOLD) {
+            recycle();
+        }
+
+        // checked for forced draw cards
+        forced_draw = 0;
+        if (force_draw_bool) {
+            if (played_card.number() == DRAW_TWO) {
+                forced_draw = 2;
+                INSTR_COUNT(counter_draw_two);
+            } else if (played_card.number() == WILD_DRAW_FOUR) {
+                forced_draw = 4;
+                INSTR_COUNT(counter_draw_four);
+            }
+            if constexpr (Rules::stacking) {
+                // nothing is drawn yet, the next player may pass the penalty on
+                stack += forced_draw;
+                forced_draw = 0;
+            } else {
+                card temp_card;
+                int drawn = 0;
+                for (; drawn < forced_draw && draw(temp_card); drawn++) {
+                    play_array[seating.get_current()].hand_add(temp_card);
+                }
+                mark_hand(seating.get_current());
+                emit(event_cards_drawn, seating.get_current(), 0, drawn);
+            }
+            force_draw_bool = false;
+        }
+    }
+};
+
+typedef BasicEngine<StandardRules> GameEngine;
+
+/**
+ * Built-in policy for headless games: play the first card that fits (holding
+ * wilds back until nothing else fits, then naming the colour held most),
+ * otherwise draw, and always play a drawn card that fits.
+ */
+template <class Rules, class Events>
+inline Move simple_policy(const BasicEngine<Rules, Events>& engine) {
+    if (engine.is_drawn_pending()) {
+        return Move(play_drawn);
+    }
+
+    const player& curr_player = engine.get_player(engine.get_turn());
+    PlayableMask mask = engine.playable_mask();
+    // codes 0-15 are the wild cards
+    uint64_t colored[2] = {mask.bits[0] & ~0xFFFFULL, mask.bits[1]};
+    for (int word = 0; word < 2; word++) {
+        if (colored[word] != 0) {
+            card temp = player::from_code(word * 64 + __builtin_ctzll(colored[word]));
+            return Move(play_card, curr_player.index_of(temp));
+        }
+    }
+    if (mask.bits[0] == 0) {
+        return Move(draw_card);
+    }
+
+    int best = red;
+    for (int col = green; col <= yellow; col++) {
+        if (curr_player.color_count(static_cast<COLOR> (col)) > curr_player.color_count(static_cast<COLOR> (best))) {
+            best = col;
+        }
+    }
+    card temp = player::from_code(__builtin_ctzll(mask.bits[0]));
+    return Move(play_card, curr_player.index_of(temp), static_cast<COLOR> (best));
+}
+
+struct SimulationResult {
+    long long games;
+    long long unfinished; // games stopped after MAX_TURNS without a winner
+    long long total_turns;
+    long long wins[MAX_PLAYERS];
+
+    SimulationResult() : games(0), unfinished(0), total_turns(0) {
+        for (int i = 0; i < MAX_PLAYERS; i++) {
+            wins[i] = 0;
+        }
+    }
+
+    // Function to add the totals of another result to this one
+
+    void merge(const SimulationResult& other) {
+        games += other.games;
+        unfinished += other.unfinished;
+        total_turns += other.total_turns;
+        for (int i = 0; i < MAX_PLAYERS; i++) {
+            wins[i] += other.wins[i];
+        }
+    }
+};
+
+// Function to play one full game with simple_policy for every seat and add its outcome to result
+
+template <class Rules, class Events>
+inline void play_game(BasicEngine<Rules, Events>& engine, int amount_players, uint64_t seed, SimulationResult& result) {
+    engine.new_game(amount_players, seed);
+    while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+        Move move;
+        {
+            INSTR_PHASE(phase_select);
+            move = simple_policy(engine);
+        }
+        engine.step(move);
+    }
+
+    result.games++;
+    result.total_turns += engine.get_turn_count();
+    if (engine.is_over()) {
+        result.wins[engine.get_winner()]++;
+    } else {
+        result.unfinished++;
+    }
+}
+
+// Function to play n_games full games under Rules, game i is seeded with game_seed(seed, i)
+
+template <class Rules = StandardRules>
+inline SimulationResult run_games(long long n_games, uint64_t seed, int amount_players) {
+    SimulationResult result;
+    BasicEngine<Rules> engine;
+    for (long long i = 0; i < n_games; i++) {
+        play_game(engine, amount_players, game_seed(seed, i), result);
+    }
+    return result;
+}
+
+#endif /* GAME_ENGINE_H */
@@ -0,0 +1,59 @@
+/*
+ * File:   game_events.h
+ *
+ * The typed events a GameEngine can emit while it plays, and the sink that
+ * emits nothing.
+ */
+
+#ifndef GAME_EVENTS_H
+#define GAME_EVENTS_H
+
+#include <cstdint>
+
+enum EVENT_TYPE {
+    event_game_started, // seat starts, count players at the table
+    event_card_played, // seat put card `value` on the discard pile
+    event_cards_drawn, // seat drew count cards
+    event_color_chosen, // seat named colour `value` for its wild
+    event_reshuffled, // count discarded cards went back into the main deck
+    event_game_won // seat played its last card
+};
+
+/**
+ * Struct: GameEvent
+ * Description:
+ * One thing that happened in one game, 16 bytes so that four share a cache
+ * line in an event queue. `game` is the seed the game was started with,
+ * which tells games apart, and `turn` the engine's turn count at the time.
+ * The type, the seat and the value (a card code or a colour) share 16 bits,
+ * which leaves 16 bits for `count`: a long run of draws or the reshuffle of a
+ * multi-deck discard pile can pass 255 cards.
+ */
+struct GameEvent {
+    uint64_t game;
+    int32_t turn;
+    uint16_t type : 3;
+    uint16_t seat : 6; // less than MAX_SEATS
+    uint16_t value : 7; // less than CARD_CODES
+    uint16_t count;
+};
+
+static_assert(sizeof (GameEvent) == 16, "four events share a cache line");
+
+/**
+ * Struct: NoEvents
+ * Description:
+ * The event sink of an engine nobody observes. `enabled` is false, so every
+ * place the engine would emit an event compiles to nothing.
+ *
+ * A sink that does observe sets `enabled` and has `emit(const GameEvent&)`,
+ * which must never block the game loop (see BusSink in event_bus.h).
+ */
+struct NoEvents {
+    static constexpr bool enabled = false;
+
+    void emit(const GameEvent&) {
+    }
+};
+
+#endif /* GAME_EVENTS_H */
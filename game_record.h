@@ -0,0 +1,442 @@
+/*
+ * File:   game_record.h
+ *
+ * Compact binary log of played games: a buffered streaming writer, a
+ * memory-mapped reader and a replayer that checks a record against the engine.
+ *
+ * File layout (all integers little endian):
+ *   "UNOREC02" (version 01 records came from an engine that recycled the
+ *   discard pile in another order, so they no longer replay)
+ *   one record per game:
+ *     u64 seed, u8 players, u8 winner (0xFF when unfinished), u16 reserved,
+ *     u32 turns, u32 decisions, u32 payload bytes, then the payload
+ *   index: u64 file offset of every RECORD_INDEX_STRIDE-th record
+ *   footer: u64 games, u64 index offset, u64 index entries, "UNOIDX01"
+ *
+ * The payload holds one entry per decision: the position of the chosen move
+ * in GameEngine::legal_moves, in just enough bits to tell the legal moves
+ * apart. Forced draws take no bits at all and a play-or-keep choice one bit.
+ * A file without footer (a run that was cut short) can still be read front
+ * to back.
+ */
+
+#ifndef GAME_RECORD_H
+#define GAME_RECORD_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "game_engine.h"
+
+#define RECORD_MAGIC "UNOREC02"
+#define RECORD_INDEX_MAGIC "UNOIDX01"
+#define RECORD_HEADER_SIZE 24
+#define RECORD_FOOTER_SIZE 32
+#define RECORD_INDEX_STRIDE 1024
+#define RECORD_BUFFER_SIZE (1 << 20)
+
+// Function to get the number of bits needed to tell n choices apart
+
+inline int choice_bits(int n) {
+    return n <= 1 ? 0 : 32 - __builtin_clz(n - 1);
+}
+
+inline void put_u64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (uint8_t) (value >> (8 * i));
+    }
+}
+
+inline void put_u32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (uint8_t) (value >> (8 * i));
+    }
+}
+
+inline uint64_t get_u64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= (uint64_t) in[i] << (8 * i);
+    }
+    return value;
+}
+
+inline uint32_t get_u32(const uint8_t* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t) in[i] << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * Class: GameRecordWriter
+ * Description:
+ * Appends games to a record file through a large in-memory buffer, so the
+ * simulation only pays for a bit-pack per decision and an fwrite per
+ * megabyte.
+ *
+ * Functionality:
+ * - `open`: Creates the file and writes the file header.
+ * - `begin_game`: Starts the record of a game.
+ * - `add_choice`: Appends one decision: choice `choice` out of `n_choices`.
+ * - `end_game`: Finishes the game record with its outcome.
+ * - `close`: Writes the index and footer and closes the file, false if any write
+ *   since `open` failed.
+ */
+class GameRecordWriter {
+public:
+
+    GameRecordWriter() : file(NULL), failed(false), offset(0), games(0), bit_buffer(0), bit_count(0), decisions(0), seed(0), amount_players(0) {
+    }
+
+    ~GameRecordWriter() {
+        close();
+    }
+
+    bool open(const char* path) {
+        file = fopen(path, "wb");
+        if (file == NULL) {
+            return false;
+        }
+        buffer.reserve(RECORD_BUFFER_SIZE + 64 * 1024);
+        buffer.clear();
+        index.clear();
+        offset = 0;
+        games = 0;
+        failed = false;
+        append(reinterpret_cast<const uint8_t*> (RECORD_MAGIC), 8);
+        return true;
+    }
+
+    void begin_game(uint64_t seed, int amount_players) {
+        this->seed = seed;
+        this->amount_players = amount_players;
+        payload.clear();
+        bit_buffer = 0;
+        bit_count = 0;
+        decisions = 0;
+    }
+
+    void add_choice(int choice, int n_choices) {
+        int bits = choice_bits(n_choices);
+        bit_buffer |= (uint64_t) choice << bit_count;
+        bit_count += bits;
+        while (bit_count >= 8) {
+            payload.push_back((uint8_t) bit_buffer);
+            bit_buffer >>= 8;
+            bit_count -= 8;
+        }
+        decisions++;
+    }
+
+    // Function to finish the current game, winner is -1 for a game that was stopped without one
+
+    void end_game(int winner, int turns) {
+        if (bit_count > 0) {
+            payload.push_back((uint8_t) bit_buffer);
+        }
+        if (games % RECORD_INDEX_STRIDE == 0) {
+            index.push_back(offset + buffer.size());
+        }
+
+        uint8_t header[RECORD_HEADER_SIZE];
+        put_u64(header, seed);
+        header[8] = (uint8_t) amount_players;
+        header[9] = winner < 0 ? 0xFF : (uint8_t) winner;
+        header[10] = 0;
+        header[11] = 0;
+        put_u32(header + 12, turns);
+        put_u32(header + 16, decisions);
+        put_u32(header + 20, payload.size());
+        append(header, RECORD_HEADER_SIZE);
+        append(payload.data(), payload.size());
+        games++;
+    }
+
+    bool close() {
+        if (file == NULL) {
+            return false;
+        }
+        uint64_t index_offset = offset + buffer.size();
+        uint8_t word[8];
+        for (uint64_t entry : index) {
+            put_u64(word, entry);
+            append(word, 8);
+        }
+        uint8_t footer[RECORD_FOOTER_SIZE];
+        put_u64(footer, games);
+        put_u64(footer + 8, index_offset);
+        put_u64(footer + 16, index.size());
+        std::memcpy(footer + 24, RECORD_INDEX_MAGIC, 8);
+        append(footer, RECORD_FOOTER_SIZE);
+
+        flush();
+        bool ok = fclose(file) == 0 && !failed;
+        file = NULL;
+        return ok;
+    }
+
+    long long get_games() const {
+        return games;
+    }
+
+private:
+    FILE* file;
+    bool failed; // some write since open came up short, the file is unusable
+    std::vector<uint8_t> buffer;
+    std::vector<uint8_t> payload;
+    std::vector<uint64_t> index;
+    uint64_t offset; // bytes already written to the file
+    long long games;
+    uint64_t bit_buffer;
+    int bit_count;
+    uint32_t decisions;
+    uint64_t seed;
+    int amount_players;
+
+    void append(const uint8_t* data, size_t n) {
+        buffer.insert(buffer.end(), data, data + n);
+        if (buffer.size() >= RECORD_BUFFER_SIZE) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            failed = true;
+        }
+        offset += buffer.size();
+        buffer.clear();
+    }
+};
+
+/**
+ * One game inside a mapped record file. The payload points straight into the
+ * mapping, nothing is copied.
+ */
+struct GameRecordView {
+    uint64_t seed;
+    int amount_players;
+    int winner; // -1 when the game was stopped without one
+    uint32_t turns;
+    uint32_t decisions;
+    uint32_t payload_size;
+    const uint8_t* payload;
+};
+
+/**
+ * Class: GameRecordReader
+ * Description:
+ * Maps a record file read-only and walks it in place. Sequential iteration
+ * needs nothing but the mapping; random access jumps to the nearest indexed
+ * record and skips at most RECORD_INDEX_STRIDE - 1 headers from there.
+ *
+ * Functionality:
+ * - `open`: Maps the file and checks its header and footer.
+ * - `next`: Reads the record under the cursor and moves past it, false at the end or at a damaged record.
+ * - `at_end`: Tells the end of the records from a damaged record after `next` failed.
+ * - `rewind`: Moves the cursor back to the first record.
+ * - `get_game`: Reads game number i.
+ * - `get_game_count`: Gets the number of games (from the footer, or counted).
+ */
+class GameRecordReader {
+public:
+
+    GameRecordReader() : data(NULL), size(0), end(0), cursor(0), games(0), index(NULL), index_entries(0) {
+    }
+
+    ~GameRecordReader() {
+        close();
+    }
+
+    bool open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < 8) {
+            ::close(fd);
+            return false;
+        }
+        size = info.st_size;
+        void* mapped = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            size = 0;
+            return false;
+        }
+        data = static_cast<const uint8_t*> (mapped);
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        if (size < 8 || std::memcmp(data, RECORD_MAGIC, 8) != 0) {
+            close();
+            return false;
+        }
+
+        end = size;
+        games = -1;
+        if (size >= 8 + RECORD_FOOTER_SIZE && std::memcmp(data + size - 8, RECORD_INDEX_MAGIC, 8) == 0) {
+            const uint8_t* footer = data + size - RECORD_FOOTER_SIZE;
+            games = get_u64(footer);
+            end = get_u64(footer + 8);
+            index_entries = get_u64(footer + 16);
+            // the records, then the index, then the footer, each inside the file
+            uint64_t before_footer = size - RECORD_FOOTER_SIZE;
+            if (end < 8 || end > before_footer || index_entries > (before_footer - end) / 8) {
+                close();
+                return false;
+            }
+            index = data + end;
+        }
+        rewind();
+        return true;
+    }
+
+    void close() {
+        if (data != NULL) {
+            munmap(const_cast<uint8_t*> (data), size);
+        }
+        data = NULL;
+        size = 0;
+        index = NULL;
+        index_entries = 0;
+    }
+
+    void rewind() {
+        cursor = 8;
+    }
+
+    // Function to check whether the cursor has passed every record, when next fails before that the file is damaged
+
+    bool at_end() const {
+        return cursor >= end;
+    }
+
+    bool next(GameRecordView& out) {
+        if (cursor + RECORD_HEADER_SIZE > end) {
+            return false;
+        }
+        const uint8_t* header = data + cursor;
+        out.seed = get_u64(header);
+        out.amount_players = header[8];
+        out.winner = header[9] == 0xFF ? -1 : header[9];
+        out.turns = get_u32(header + 12);
+        out.decisions = get_u32(header + 16);
+        out.payload_size = get_u32(header + 20);
+        out.payload = header + RECORD_HEADER_SIZE;
+        if (cursor + RECORD_HEADER_SIZE + out.payload_size > end) {
+            return false;
+        }
+        // a damaged file must not be able to start a game the engine has no room for
+        if (out.amount_players < MIN_PLAYERS || out.amount_players > MAX_PLAYERS || out.winner >= out.amount_players) {
+            return false;
+        }
+        cursor += RECORD_HEADER_SIZE + out.payload_size;
+        return true;
+    }
+
+    // Function to read game i, leaves the cursor just after it
+
+    bool get_game(long long i, GameRecordView& out) {
+        if (i < 0 || (games >= 0 && i >= games)) {
+            return false;
+        }
+        long long first = 0;
+        rewind();
+        if (index != NULL && (uint64_t) (i / RECORD_INDEX_STRIDE) < index_entries) {
+            uint64_t indexed = get_u64(index + 8 * (i / RECORD_INDEX_STRIDE));
+            if (indexed < 8 || indexed >= end) {
+                return false;
+            }
+            first = i / RECORD_INDEX_STRIDE * RECORD_INDEX_STRIDE;
+            cursor = indexed;
+        }
+        for (long long k = first; k < i; k++) {
+            if (cursor + RECORD_HEADER_SIZE > end) {
+                return false;
+            }
+            cursor += RECORD_HEADER_SIZE + get_u32(data + cursor + 20);
+        }
+        return next(out);
+    }
+
+    long long get_game_count() {
+        if (games < 0) {
+            GameRecordView view;
+            uint64_t saved = cursor;
+            rewind();
+            games = 0;
+            while (next(view)) {
+                games++;
+            }
+            cursor = saved;
+        }
+        return games;
+    }
+
+private:
+    const uint8_t* data;
+    uint64_t size;
+    uint64_t end; // where the records stop (start of the index)
+    uint64_t cursor;
+    long long games;
+    const uint8_t* index;
+    uint64_t index_entries;
+};
+
+// Function to play one game with simple_policy, like play_game, and append it to writer
+
+inline void record_game(GameEngine& engine, int amount_players, uint64_t seed, GameRecordWriter& writer, std::vector<Move>& moves) {
+    engine.new_game(amount_players, seed);
+    writer.begin_game(seed, amount_players);
+    while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+        Move move = simple_policy(engine);
+        engine.legal_moves(moves);
+        int choice = 0;
+        while (!(moves[choice] == move)) {
+            choice++;
+        }
+        writer.add_choice(choice, moves.size());
+        engine.step(move);
+    }
+    writer.end_game(engine.get_winner(), engine.get_turn_count());
+}
+
+// Function to drive engine through a recorded game, returns true if it ends exactly as recorded
+
+inline bool replay_game(const GameRecordView& record, GameEngine& engine, std::vector<Move>& moves) {
+    engine.new_game(record.amount_players, record.seed);
+    uint64_t bit_buffer = 0;
+    int bit_count = 0;
+    uint32_t byte = 0;
+    for (uint32_t d = 0; d < record.decisions; d++) {
+        engine.legal_moves(moves);
+        if (moves.empty()) {
+            return false;
+        }
+        int bits = choice_bits(moves.size());
+        while (bit_count < bits) {
+            if (byte >= record.payload_size) {
+                return false;
+            }
+            bit_buffer |= (uint64_t) record.payload[byte++] << bit_count;
+            bit_count += 8;
+        }
+        uint32_t choice = bit_buffer & ((1ULL << bits) - 1);
+        bit_buffer >>= bits;
+        bit_count -= bits;
+        if (choice >= moves.size() || engine.step(moves[choice]) != step_ok) {
+            return false;
+        }
+    }
+    return engine.get_winner() == record.winner && (uint32_t) engine.get_turn_count() == record.turns;
+}
+
+#endif /* GAME_RECORD_H */
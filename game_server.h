@@ -0,0 +1,645 @@
+/*
+ * File:   game_server.h
+ *
+ * Multi-table game server: every table is a C++20 coroutine that suspends
+ * whenever a seat has to answer, and one epoll loop drives all of them.
+ */
+
+#ifndef GAME_SERVER_H
+#define GAME_SERVER_H
+
+#if __cplusplus < 202002L
+#error "game_server.h needs C++20 coroutines, build with -std=c++20"
+#endif
+
+#include <coroutine>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include "flat_map.h"
+#include "game_engine.h"
+#include "local_socket.h"
+
+#define SERVER_EVENTS 256 // epoll events taken per wait
+#define SERVER_MOVE_TIMEOUT_MS 30000
+
+enum REPLY_STATUS {
+    reply_line, reply_timeout, reply_closed
+};
+
+struct Reply {
+    REPLY_STATUS status;
+    std::string line;
+};
+
+/**
+ * The coroutine type of a table. It starts running as soon as it is called
+ * and frees its own frame when the game is over; the server only ever holds
+ * the handle of a table that is waiting for an answer.
+ */
+struct TableTask {
+
+    struct promise_type {
+
+        TableTask get_return_object() {
+            return TableTask();
+        }
+
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() {
+        }
+
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+};
+
+struct Table;
+
+/**
+ * One client. While it sits at a table its lines are answers for that table,
+ * otherwise they are lobby commands. While it waits at an open table for the
+ * seats to fill (`pending`), every lobby command is answered INVALID, so a
+ * client takes at most one seat at a time. A connection that closes while
+ * its table still refers to it stays allocated until the table lets go.
+ */
+struct Connection {
+    uint64_t id;
+    int fd;
+    bool closed;
+    bool write_blocked; // EPOLLOUT is armed until out drains
+    LineBuffer in;
+    std::string out;
+    Table* table;
+    Table* pending; // the open table it took a seat at, until that table starts
+    std::coroutine_handle<> waiting; // the table waiting for an answer from this connection
+    uint32_t prompt; // number of the last prompt sent, see local_socket.h
+    bool answered; // answer holds the answer to that prompt
+    std::string answer; // without the prompt number
+    int64_t deadline_ns; // of the current wait
+    bool timer_queued; // the connection has an entry in the timer heap
+
+    Connection(uint64_t id, int fd) : id(id), fd(fd), closed(false), write_blocked(false), table(NULL), pending(NULL),
+    prompt(0), answered(false), deadline_ns(0), timer_queued(false) {
+    }
+};
+
+// Function to read the connection's lines up to the answer to its current prompt, dropping answers to earlier
+// prompts and anything unnumbered, returns whether the answer is there
+
+inline bool take_answer(Connection* connection) {
+    std::string line;
+    while (!connection->answered && connection->in.next_line(line)) {
+        char* end = NULL;
+        unsigned long prompt = std::strtoul(line.c_str(), &end, 10);
+        if (end != line.c_str() && *end == ' ' && prompt == connection->prompt) {
+            connection->answer.assign(end + 1);
+            connection->answered = true;
+        }
+    }
+    return connection->answered;
+}
+
+struct Table {
+    uint64_t id;
+    int amount_players;
+    int amount_bots; // the last seats are played by the server
+    int joined;
+    Connection* seats[MAX_PLAYERS]; // NULL for a server seat
+    GameEngine engine;
+};
+
+/**
+ * A connection's entry in the timer heap. There is at most one per
+ * connection, and its deadline may be older than the connection's current
+ * one: a wait that ends early leaves the entry in place, and when it comes up
+ * it is pushed again with the deadline of whatever wait is current. So the
+ * heap never holds more entries than there are connections, however many
+ * moves are made.
+ */
+struct ReplyTimer {
+    int64_t deadline_ns;
+    uint64_t connection;
+
+    bool operator>(const ReplyTimer& other) const {
+        return deadline_ns > other.deadline_ns;
+    }
+};
+
+class GameServer;
+
+/**
+ * Awaitable for the answer of a seat to its current prompt. Ready at once
+ * when the client has already sent it, otherwise the table suspends until
+ * the answer arrives, the move timeout passes or the client leaves.
+ */
+struct ReplyAwaiter {
+    GameServer& server;
+    Connection* connection;
+
+    bool await_ready() const {
+        return connection->closed || take_answer(connection);
+    }
+
+    void await_suspend(std::coroutine_handle<> handle);
+    Reply await_resume();
+};
+
+/**
+ * Class: GameServer
+ * Description:
+ * Hosts any number of tables in one thread. Sockets are non-blocking and
+ * level triggered in one epoll set; per-move deadlines sit in a min-heap
+ * whose earliest entry bounds every epoll_wait. A table coroutine runs
+ * until it needs an answer from a client, so bot seats and every state
+ * change are handled inline and the only suspension points are the
+ * decisions the interactive game asks for: the move, the colour of a wild
+ * and whether to play a drawn card. The hot seat confirmation has no
+ * counterpart, as every client sees only its own hand.
+ *
+ * A seat whose client does not answer within the move timeout is played by
+ * simple_policy for that decision, and TIMEOUT tells the client which move
+ * that was; a seat whose client leaves is played by simple_policy for the
+ * rest of the game. Prompts are numbered, so an answer that comes after its
+ * prompt timed out is dropped instead of answering the next one.
+ *
+ * Functionality:
+ * - `start`: Opens the listening socket and the epoll set.
+ * - `run`: Serves until `stop` is called.
+ * - `reply`: What a table co_awaits for the next line of a seat.
+ * - `send`: Queues a line for a connection.
+ */
+class GameServer {
+public:
+
+    GameServer(int move_timeout_ms) : move_timeout_ns((int64_t) move_timeout_ms * 1000000), listen_fd(-1), epoll_fd(-1),
+    stopping(false), next_connection(1), next_table(1) {
+    }
+
+    ~GameServer() {
+        for (auto& entry : connections) {
+            close(entry.value->fd);
+        }
+        if (listen_fd >= 0) {
+            close(listen_fd);
+        }
+        if (epoll_fd >= 0) {
+            close(epoll_fd);
+        }
+    }
+
+    bool start(const LocalAddress& address) {
+        raise_file_limit();
+        listen_fd = address.listen_on();
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (listen_fd < 0 || epoll_fd < 0 || !set_nonblocking(listen_fd)) {
+            return false;
+        }
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = 0;
+        return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) == 0;
+    }
+
+    void stop() {
+        stopping = true;
+    }
+
+    void run() {
+        epoll_event events[SERVER_EVENTS];
+        while (!stopping) {
+            int n = epoll_wait(epoll_fd, events, SERVER_EVENTS, wait_ms());
+            if (n < 0 && errno != EINTR) {
+                perror("epoll_wait");
+                return;
+            }
+            for (int i = 0; i < n; i++) {
+                if (events[i].data.u64 == 0) {
+                    accept_all();
+                    continue;
+                }
+                Connection* connection = find(events[i].data.u64);
+                if (connection == NULL) {
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT) {
+                    write_out(connection);
+                }
+                if (!connection->closed && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                    if (!connection->in.fill(connection->fd) || connection->in.overflowed()) {
+                        mark_closed(connection);
+                    }
+                }
+                ready.push_back(connection->id);
+            }
+            expire_timers();
+            drain_ready();
+        }
+    }
+
+    ReplyAwaiter reply(Connection* connection) {
+        return ReplyAwaiter{*this, connection};
+    }
+
+    // Function to send a prompt, "<kind> <n> <fields>", under the connection's next prompt number
+
+    void send_prompt(Connection* connection, const char* kind, const std::string& fields = "") {
+        connection->prompt++;
+        connection->answered = false;
+        send(connection, kind + (" " + std::to_string(connection->prompt)) + (fields.empty() ? "" : " " + fields));
+    }
+
+    void send(Connection* connection, const std::string& line) {
+        if (connection->closed) {
+            return;
+        }
+        connection->out += line;
+        connection->out += '\n';
+        if (!connection->write_blocked) {
+            write_out(connection);
+        }
+    }
+
+    // Function to park the table of a connection until it answers or its move timeout passes
+
+    void wait_for(Connection* connection, std::coroutine_handle<> handle) {
+        connection->waiting = handle;
+        connection->deadline_ns = now_ns() + move_timeout_ns;
+        if (!connection->timer_queued) {
+            connection->timer_queued = true;
+            timers.push(ReplyTimer{connection->deadline_ns, connection->id});
+        }
+    }
+
+    // Function to hand the seats of a finished table back to the lobby, called by the table itself
+
+    void finish(Table* table) {
+        for (int seat = 0; seat < table->amount_players; seat++) {
+            Connection* connection = table->seats[seat];
+            if (connection != NULL) {
+                connection->table = NULL;
+                ready.push_back(connection->id);
+            }
+        }
+        finished.push_back(table->id);
+    }
+
+    static int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    int64_t move_timeout_ns;
+    int listen_fd;
+    int epoll_fd;
+    volatile sig_atomic_t stopping; // set from a signal handler
+    uint64_t next_connection;
+    uint64_t next_table;
+    FlatMap<uint64_t, std::unique_ptr<Connection>> connections;
+    FlatMap<uint64_t, std::unique_ptr<Table>> tables;
+    Table* open_tables[MAX_PLAYERS + 1][MAX_PLAYERS + 1] = {}; // [players][bots], the table still taking seats
+    std::priority_queue<ReplyTimer, std::vector<ReplyTimer>, std::greater<ReplyTimer>> timers;
+    std::vector<uint64_t> ready; // connections with something to do
+    std::vector<uint64_t> finished; // tables whose coroutine has ended
+
+    Connection* find(uint64_t id) {
+        std::unique_ptr<Connection>* found = connections.find(id);
+        return found == NULL ? NULL : found->get();
+    }
+
+    int wait_ms() const {
+        if (!ready.empty()) {
+            return 0;
+        }
+        if (timers.empty()) {
+            return -1;
+        }
+        int64_t left = timers.top().deadline_ns - now_ns();
+        return left <= 0 ? 0 : (int) (left / 1000000 + 1);
+    }
+
+    void accept_all() {
+        while (true) {
+            int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof (on)); // fails harmlessly on Unix sockets
+            uint64_t id = next_connection++;
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.u64 = id;
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+                close(fd);
+                continue;
+            }
+            connections[id] = std::make_unique<Connection>(id, fd);
+        }
+    }
+
+    void write_out(Connection* connection) {
+        while (!connection->out.empty()) {
+            ssize_t n = ::send(connection->fd, connection->out.data(), connection->out.size(), MSG_NOSIGNAL);
+            if (n > 0) {
+                connection->out.erase(0, n);
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                mark_closed(connection);
+                ready.push_back(connection->id);
+                return;
+            }
+        }
+        bool blocked = !connection->out.empty();
+        if (blocked != connection->write_blocked) {
+            connection->write_blocked = blocked;
+            epoll_event event = {};
+            event.events = EPOLLIN | (blocked ? (uint32_t) EPOLLOUT : 0u);
+            event.data.u64 = connection->id;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+        }
+    }
+
+    // Function to stop watching a connection that failed, its descriptor is closed once nothing refers to it
+
+    void mark_closed(Connection* connection) {
+        connection->closed = true;
+        connection->out.clear();
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    }
+
+    void expire_timers() {
+        int64_t now = now_ns();
+        while (!timers.empty() && timers.top().deadline_ns <= now) {
+            Connection* connection = find(timers.top().connection);
+            timers.pop();
+            if (connection == NULL || !connection->waiting) {
+                if (connection != NULL) {
+                    connection->timer_queued = false;
+                }
+            } else if (connection->deadline_ns <= now) {
+                connection->timer_queued = false;
+                resume(connection);
+            } else {
+                timers.push(ReplyTimer{connection->deadline_ns, connection->id});
+            }
+        }
+    }
+
+    // Function to let every connection that was marked ready act: resume its table or run its lobby commands
+
+    void drain_ready() {
+        for (size_t i = 0; i < ready.size(); i++) {
+            Connection* connection = find(ready[i]);
+            if (connection == NULL) {
+                continue;
+            }
+            if (connection->table != NULL) {
+                if (connection->waiting && (connection->closed || take_answer(connection))) {
+                    resume(connection);
+                }
+            } else {
+                lobby(connection);
+            }
+        }
+        ready.clear();
+        for (uint64_t id : finished) {
+            tables.erase(id);
+        }
+        finished.clear();
+    }
+
+    void resume(Connection* connection) {
+        std::coroutine_handle<> handle = connection->waiting;
+        connection->waiting = nullptr;
+        handle.resume();
+    }
+
+    void lobby(Connection* connection) {
+        std::string line;
+        while (connection->table == NULL && !connection->closed && connection->in.next_line(line)) {
+            int players = 0, bots = 0;
+            if (connection->pending != NULL) {
+                send(connection, "INVALID");
+            } else if (line == "STATS") {
+                rusage usage;
+                getrusage(RUSAGE_SELF, &usage);
+                long long cpu_us = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+                send(connection, "STATS " + std::to_string(cpu_us) + " " + std::to_string(tables.size()) + " " + std::to_string(connections.size()));
+            } else if (std::sscanf(line.c_str(), "JOIN %d %d", &players, &bots) == 2 && players >= MIN_PLAYERS
+                    && players <= MAX_PLAYERS && bots >= 0 && bots < players) {
+                join(connection, players, bots);
+            } else {
+                send(connection, "INVALID");
+            }
+        }
+        if (connection->closed && connection->table == NULL) {
+            close(connection->fd);
+            remove_seat(connection->pending, connection);
+            connection->pending = NULL;
+            connections.erase(connection->id);
+        }
+    }
+
+    // Function to drop a connection that left before its table started
+
+    void remove_seat(Table* table, Connection* connection) {
+        if (table == NULL) {
+            return;
+        }
+        for (int seat = 0; seat < table->joined; seat++) {
+            if (table->seats[seat] == connection) {
+                table->seats[seat] = table->seats[--table->joined];
+                return;
+            }
+        }
+    }
+
+    void join(Connection* connection, int players, int bots) {
+        Table*& table = open_tables[players][bots];
+        if (table == NULL) {
+            uint64_t id = next_table++;
+            std::unique_ptr<Table> created = std::make_unique<Table>();
+            created->id = id;
+            created->amount_players = players;
+            created->amount_bots = bots;
+            created->joined = 0;
+            for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+                created->seats[seat] = NULL;
+            }
+            table = created.get();
+            tables[id] = std::move(created);
+        }
+        table->seats[table->joined++] = connection;
+        connection->pending = table;
+        if (table->joined + table->amount_bots == table->amount_players) {
+            Table* full = table;
+            table = NULL;
+            for (int seat = 0; seat < full->joined; seat++) {
+                full->seats[seat]->pending = NULL;
+                full->seats[seat]->table = full;
+            }
+            play_table(*this, full, now_ns() ^ full->id);
+        }
+    }
+
+    friend TableTask play_table(GameServer& server, Table* table, uint64_t seed);
+};
+
+inline void ReplyAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    server.wait_for(connection, handle);
+}
+
+inline Reply ReplyAwaiter::await_resume() {
+    Reply reply;
+    if (connection->answered) {
+        reply.line.swap(connection->answer);
+        connection->answered = false;
+        reply.status = reply_line;
+    } else {
+        reply.status = connection->closed ? reply_closed : reply_timeout;
+    }
+    return reply;
+}
+
+inline COLOR color_from_name(const std::string& name) {
+    return name == "red" ? red : name == "green" ? green : name == "blue" ? blue : name == "yellow" ? yellow : wild;
+}
+
+inline const char* color_to_name(COLOR col) {
+    static const char* names[5] = {"wild", "red", "green", "blue", "yellow"};
+    return names[col];
+}
+
+// Function to describe a move of the player to move the way TIMEOUT reports it: PLAY <card> [<colour>], DRAW or KEEP
+
+inline std::string move_text(const GameEngine& engine, const Move& move) {
+    if (move.type == keep_drawn) {
+        return "KEEP";
+    }
+    if (move.type == play_drawn) {
+        return "PLAY " + std::to_string(engine.get_drawn_card().get_code());
+    }
+    if (move.type != play_card) {
+        return "DRAW";
+    }
+    card temp = engine.get_player(engine.get_turn()).peek(move.index);
+    std::string text = "PLAY " + std::to_string(temp.get_code());
+    return temp.color() == wild ? text + " " + color_to_name(move.color) : text;
+}
+
+// Function to let simple_policy move for a seat that did not answer in time, and tell the seat what it played
+
+inline void move_for(GameServer& server, Connection* connection, GameEngine& engine) {
+    Move move = simple_policy(engine);
+    server.send(connection, "TIMEOUT " + move_text(engine, move));
+    engine.step(move);
+}
+
+// Function to tell the player to move what they hold and what they have to follow, the fields of a MOVE prompt
+
+inline std::string move_prompt(const GameEngine& engine) {
+    card cards[DECK_SIZE];
+    int size = engine.get_player(engine.get_turn()).get_cards(cards);
+    std::string line = std::to_string(engine.get_played_card().get_code()) + " " + std::to_string(engine.get_forced_draw());
+    line += " " + std::to_string(size);
+    for (int i = 0; i < size; i++) {
+        line += " " + std::to_string(cards[i].get_code());
+    }
+    return line;
+}
+
+/**
+ * One game at one table, the way the interactive loop in main.cpp plays it
+ * but with every prompt sent to the seat's connection. Suspends only while
+ * waiting for an answer. A connection that fails mid game turns its seat
+ * into a server seat for good. An answer that is not a number, a position
+ * in the hand or -1 is refused like an unplayable card.
+ */
+inline TableTask play_table(GameServer& server, Table* table, uint64_t seed) {
+    GameEngine& engine = table->engine;
+    engine.new_game(table->amount_players, seed);
+    for (int seat = 0; seat < table->amount_players; seat++) {
+        if (table->seats[seat] != NULL) {
+            server.send(table->seats[seat], "START " + std::to_string(table->amount_players) + " " + std::to_string(seat));
+        }
+    }
+
+    while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+        int seat = engine.get_turn();
+        Connection* connection = table->seats[seat];
+        if (connection == NULL || connection->closed) {
+            engine.step(simple_policy(engine));
+            continue;
+        }
+
+        bool asking_drawn = engine.is_drawn_pending();
+        if (asking_drawn) {
+            server.send_prompt(connection, "DRAWN", std::to_string(engine.get_drawn_card().get_code()));
+        } else {
+            server.send_prompt(connection, "MOVE", move_prompt(engine));
+        }
+        Reply reply = co_await server.reply(connection);
+        if (reply.status != reply_line) {
+            // a closed connection gets nothing, send drops it
+            move_for(server, connection, engine);
+            continue;
+        }
+
+        Move move(draw_card);
+        if (asking_drawn) {
+            move = Move(reply.line == "y" ? play_drawn : keep_drawn);
+        } else {
+            char* end = NULL;
+            long index = std::strtol(reply.line.c_str(), &end, 10);
+            if (end == reply.line.c_str() || *end != 0) {
+                move = Move(play_card, -1);
+            } else if (index >= 0 && index < engine.get_player(seat).get_size()) {
+                move = Move(play_card, index);
+                card temp = engine.get_player(seat).peek(index);
+                if (temp.color() == wild && temp == engine.get_played_card()) {
+                    server.send_prompt(connection, "COLOR");
+                    Reply color = co_await server.reply(connection);
+                    if (color.status != reply_line) {
+                        move_for(server, connection, engine);
+                        continue;
+                    }
+                    move.color = color_from_name(color.line);
+                }
+            } else if (index != -1) {
+                move = Move(play_card, -1);
+            }
+        }
+        // a refused move leaves the state as it was, so the same prompt goes out again
+        server.send(connection, engine.step(move) == step_ok ? "OK" : "INVALID");
+    }
+
+    std::string end = "END " + std::to_string(engine.is_over() ? engine.get_winner() : -1);
+    for (int seat = 0; seat < table->amount_players; seat++) {
+        if (table->seats[seat] != NULL) {
+            server.send(table->seats[seat], end);
+        }
+    }
+    server.finish(table);
+}
+
+#endif /* GAME_SERVER_H */
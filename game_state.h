@@ -0,0 +1,126 @@
+/*
+ * File:   game_state.h
+ *
+ * Persistent snapshots of a game, for undo and for branching what-if lines.
+ */
+
+#ifndef GAME_STATE_H
+#define GAME_STATE_H
+
+#include <memory>
+#include <vector>
+#include "card.h"
+#include "player.h"
+#include "rng.h"
+#include "seating.h"
+
+/**
+ * One card of a pile in a snapshot. A pile is a persistent stack: every node
+ * points at the card below it, so snapshots whose piles only differ at the top
+ * share everything underneath.
+ */
+struct PileNode {
+    card data;
+    int depth; // cards in the pile up to and including this one
+    std::shared_ptr<const PileNode> below;
+};
+
+/**
+ * Everything needed to put a GameEngine back where it was. Hands are shared
+ * with the previous snapshot when they did not change, piles share their
+ * common bottom part, and nothing in a node is ever modified once it is
+ * published.
+ */
+struct SnapshotNode {
+    int amount_players;
+    card played_card;
+    Seating seating;
+    bool force_draw_bool;
+    bool drawn_pending;
+    card drawn_card;
+    int forced_draw;
+    int stack;
+    int winner;
+    int turn_count;
+    int reshuffles;
+    int cards_drawn;
+    Rng rng;
+    std::vector<std::shared_ptr<const player>> hands;
+    std::shared_ptr<const PileNode> main_pile;
+    std::shared_ptr<const PileNode> temp_pile;
+};
+
+// Function to get the number of cards in a pile
+
+inline int pile_size(const std::shared_ptr<const PileNode>& pile) {
+    return pile ? pile->depth : 0;
+}
+
+// Function to build a pile holding the cards card_at(0) .. card_at(size - 1), sharing the bottom `keep` cards with
+// base. Only the cards above the shared part are read, so the cost is the cards popped off base plus the cards pushed
+
+template <class CardAt>
+inline std::shared_ptr<const PileNode> build_pile(std::shared_ptr<const PileNode> base, int keep, CardAt card_at, int size) {
+    while (pile_size(base) > keep) {
+        base = base->below;
+    }
+    for (int i = pile_size(base); i < size; i++) {
+        std::shared_ptr<PileNode> node = std::make_shared<PileNode>();
+        node->data = card_at(i);
+        node->depth = i + 1;
+        node->below = base;
+        base = node;
+    }
+    return base;
+}
+
+// Function to write the cards of a pile, bottom card first, into cards
+
+inline void read_pile(const std::shared_ptr<const PileNode>& pile, card* cards) {
+    for (const PileNode* node = pile.get(); node != NULL; node = node->below.get()) {
+        cards[node->depth - 1] = node->data;
+    }
+}
+
+/**
+ * Class: GameSnapshot
+ * Description:
+ * An immutable position taken with GameEngine::snapshot and put back with
+ * GameEngine::restore. Copying a snapshot copies one reference-counted
+ * pointer, and any number of snapshots (and threads) can share one. A new
+ * snapshot only allocates and copies the hands and pile cards that changed
+ * since the engine's previous snapshot, so a turn costs a hand or two and a
+ * few pile nodes. A reshuffle changes the order of the whole main deck, so the
+ * first snapshot after one rebuilds that pile. Restoring always rewrites both
+ * piles, which is linear in the cards of the game.
+ */
+class GameSnapshot {
+public:
+
+    GameSnapshot() {
+    }
+
+    explicit GameSnapshot(std::shared_ptr<const SnapshotNode> node) : node(node) {
+    }
+
+    bool empty() const {
+        return !node;
+    }
+
+    int get_turn_count() const {
+        return node->turn_count;
+    }
+
+    int get_turn() const {
+        return node->seating.get_current();
+    }
+
+    const SnapshotNode& get_node() const {
+        return *node;
+    }
+
+private:
+    std::shared_ptr<const SnapshotNode> node;
+};
+
+#endif /* GAME_STATE_H */
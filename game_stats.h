@@ -0,0 +1,283 @@
+/*
+ * File:   game_stats.h
+ *
+ * Streaming statistics of simulated games: per-thread accumulators of fixed
+ * size that merge into one summary, with quantiles from KLL sketches.
+ */
+
+#ifndef GAME_STATS_H
+#define GAME_STATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "card.h"
+#include "rng.h"
+#include "seating.h"
+
+#define KLL_K 200 // accuracy of a KllSketch, the rank error is about 1.7 / KLL_K
+#define KLL_SEED 0x5eed // the coin of every sketch starts here, so one thread's run always gives the same quantiles
+
+/**
+ * Class: KllSketch
+ * Description:
+ * A KLL quantile sketch (Karnin, Lang and Liberty). Values go into level 0;
+ * when a level reaches its capacity it is sorted and every other value, from
+ * a random offset, moves up one level with twice the weight. The capacities
+ * shrink by 2/3 per level below the top, so the sketch never holds more than
+ * about 3 * k values and a handful more per level, however many it has seen.
+ * Two sketches merge level by level, which is how per-thread sketches become
+ * one.
+ *
+ * Functionality:
+ * - `add`: Adds one value.
+ * - `merge`: Adds everything another sketch has seen.
+ * - `quantile`: Gets the value at a rank between 0 and 1.
+ * - `rank`: Gets the fraction of values at or below a value.
+ * - `count`: Gets how many values were added.
+ * - `retained`: Gets how many values the sketch holds right now.
+ */
+class KllSketch {
+public:
+
+    explicit KllSketch(int k = KLL_K) : k(k), seen(0), size(0), max_size(0), coin(KLL_SEED) {
+        grow();
+    }
+
+    void add(double value) {
+        levels[0].push_back(value);
+        seen++;
+        size++;
+        if (size >= max_size) {
+            compress();
+        }
+    }
+
+    void merge(const KllSketch& other) {
+        while (levels.size() < other.levels.size()) {
+            grow();
+        }
+        for (size_t h = 0; h < other.levels.size(); h++) {
+            levels[h].insert(levels[h].end(), other.levels[h].begin(), other.levels[h].end());
+        }
+        seen += other.seen;
+        size += other.size;
+        while (size >= max_size) {
+            compress();
+        }
+    }
+
+    // Function to get the smallest held value whose weighted rank reaches q
+
+    double quantile(double q) const {
+        std::vector<std::pair<double, uint64_t>> weighted = sorted_values();
+        if (weighted.empty()) {
+            return 0;
+        }
+        uint64_t total = 0;
+        for (const std::pair<double, uint64_t>& item : weighted) {
+            total += item.second;
+        }
+        double target = q * total;
+        uint64_t below = 0;
+        for (const std::pair<double, uint64_t>& item : weighted) {
+            below += item.second;
+            if (below >= target) {
+                return item.first;
+            }
+        }
+        return weighted.back().first;
+    }
+
+    double rank(double value) const {
+        uint64_t below = 0, total = 0;
+        for (size_t h = 0; h < levels.size(); h++) {
+            for (double item : levels[h]) {
+                below += item <= value ? 1ULL << h : 0;
+                total += 1ULL << h;
+            }
+        }
+        return total > 0 ? (double) below / total : 0;
+    }
+
+    uint64_t count() const {
+        return seen;
+    }
+
+    int retained() const {
+        return size;
+    }
+
+private:
+    int k;
+    uint64_t seen;
+    int size; // values held over all levels
+    int max_size; // sum of the level capacities, compress once size reaches it
+    std::vector<std::vector<double>> levels; // a value on level h stands for 2^h values
+    std::vector<int> capacities;
+    Rng coin;
+
+    // Function to add a level on top, which shrinks the capacity of all the others
+
+    void grow() {
+        levels.emplace_back();
+        int height = levels.size();
+        capacities.resize(height);
+        max_size = 0;
+        for (int h = 0; h < height; h++) {
+            capacities[h] = (int) std::ceil(k * std::pow(2.0 / 3.0, height - h - 1)) + 1;
+            max_size += capacities[h];
+        }
+        levels.back().reserve(capacities.back() + 1);
+    }
+
+    // Function to compact the lowest level that is full, halving its values into the level above
+
+    void compress() {
+        for (size_t h = 0; h < levels.size(); h++) {
+            if ((int) levels[h].size() < capacities[h]) {
+                continue;
+            }
+            if (h + 1 == levels.size()) {
+                grow();
+            }
+            std::vector<double>& level = levels[h];
+            std::sort(level.begin(), level.end());
+            // an odd value out stays behind
+            size_t pairs = level.size() / 2;
+            size_t offset = coin.next() >> 63;
+            for (size_t i = 0; i < pairs; i++) {
+                levels[h + 1].push_back(level[2 * i + offset]);
+            }
+            if (level.size() % 2 == 1) {
+                level[0] = level.back();
+                level.resize(1);
+            } else {
+                level.clear();
+            }
+            size -= pairs;
+            return;
+        }
+    }
+
+    std::vector<std::pair<double, uint64_t>> sorted_values() const {
+        std::vector<std::pair<double, uint64_t>> weighted;
+        weighted.reserve(size);
+        for (size_t h = 0; h < levels.size(); h++) {
+            for (double item : levels[h]) {
+                weighted.push_back(std::make_pair(item, 1ULL << h));
+            }
+        }
+        std::sort(weighted.begin(), weighted.end());
+        return weighted;
+    }
+};
+
+/* the per-game quantities GameStats keeps moments and a sketch of */
+enum GAME_STAT {
+    stat_turns, stat_draws, stat_reshuffles, stat_cards_left, GAME_STATS
+};
+
+/**
+ * Struct: GameStats
+ * Description:
+ * Running totals of every game added to it, in memory that does not grow
+ * with the number of games: win counts by seat and by place after the
+ * starting player, an exact histogram of the cards left in the losing
+ * hands, and a KllSketch with sum, sum of squares and maximum each for game
+ * length, cards drawn, reshuffles and cards left. Every worker keeps its own
+ * and they are merged at the end. The counts come out the same on any number
+ * of threads, the quantiles only within the sketch's error, since a sketch
+ * depends on the order it saw its games in.
+ *
+ * Functionality:
+ * - `add`: Adds the outcome of a finished (or stopped) game.
+ * - `merge`: Adds the totals of another GameStats.
+ * - `mean` / `stddev`: Moments of a tracked quantity.
+ */
+struct GameStats {
+    long long games;
+    long long unfinished;
+    long long wins[MAX_SEATS]; // by seat
+    long long starts[MAX_SEATS]; // games each seat played first
+    long long wins_after_start[MAX_SEATS]; // by seats clockwise from the starting player, 0 is the starter
+    long long cards_left[MAX_DECKS * DECK_SIZE + 1]; // losing hands by the number of cards they held at the end
+    double sums[GAME_STATS];
+    double squares[GAME_STATS];
+    double highest[GAME_STATS];
+    KllSketch sketches[GAME_STATS];
+
+    GameStats() : games(0), unfinished(0), wins(), starts(), wins_after_start(), cards_left(), sums(), squares(), highest() {
+    }
+
+    // Function to add a game that engine just finished, first is the seat that started it
+
+    template <class Engine>
+    void add(const Engine& engine, int first) {
+        games++;
+        starts[first]++;
+        int amount_players = engine.get_amount_players();
+        int winner = engine.get_winner();
+        if (winner >= 0) {
+            wins[winner]++;
+            // play always starts clockwise
+            wins_after_start[(winner - first + amount_players) % amount_players]++;
+        } else {
+            unfinished++;
+        }
+
+        int left = 0;
+        for (int i = 0; i < amount_players; i++) {
+            if (i != winner) {
+                int size = engine.get_player(i).get_size();
+                cards_left[size]++;
+                left += size;
+            }
+        }
+        record(stat_turns, engine.get_turn_count());
+        record(stat_draws, engine.get_cards_drawn());
+        record(stat_reshuffles, engine.get_reshuffles());
+        record(stat_cards_left, left);
+    }
+
+    void merge(const GameStats& other) {
+        games += other.games;
+        unfinished += other.unfinished;
+        for (int i = 0; i < MAX_SEATS; i++) {
+            wins[i] += other.wins[i];
+            starts[i] += other.starts[i];
+            wins_after_start[i] += other.wins_after_start[i];
+        }
+        for (int i = 0; i <= MAX_DECKS * DECK_SIZE; i++) {
+            cards_left[i] += other.cards_left[i];
+        }
+        for (int s = 0; s < GAME_STATS; s++) {
+            sums[s] += other.sums[s];
+            squares[s] += other.squares[s];
+            highest[s] = std::max(highest[s], other.highest[s]);
+            sketches[s].merge(other.sketches[s]);
+        }
+    }
+
+    double mean(GAME_STAT stat) const {
+        return games > 0 ? sums[stat] / games : 0;
+    }
+
+    double stddev(GAME_STAT stat) const {
+        double m = mean(stat);
+        return games > 0 ? std::sqrt(std::max(0.0, squares[stat] / games - m * m)) : 0;
+    }
+
+private:
+
+    void record(GAME_STAT stat, double value) {
+        sums[stat] += value;
+        squares[stat] += value * value;
+        highest[stat] = std::max(highest[stat], value);
+        sketches[stat].add(value);
+    }
+};
+
+#endif /* GAME_STATS_H */
@@ -0,0 +1,180 @@
+/*
+ * File:   heuristic_bot.h
+ *
+ * A bot that scores every legal move as a weighted sum of features of the
+ * position and plays the best one. The weights are what bot_tuner.h tunes.
+ */
+
+#ifndef HEURISTIC_BOT_H
+#define HEURISTIC_BOT_H
+
+#include "card.h"
+#include "game_engine.h"
+#include "player.h"
+
+/* what a move is scored on, each about 0 to 1 */
+enum HEURISTIC_FEATURE {
+    feature_draw, // the move draws, or keeps the card just drawn, instead of playing
+    feature_color_share, // share of the cards left in hand that have the colour the move leaves on top
+    feature_color_change, // the move changes the colour on top
+    feature_wild, // the move plays a wild card
+    feature_wild_late, // a wild played from a small hand: 1 / the cards in hand
+    feature_action, // the move plays a skip, reverse or Draw-2
+    feature_action_threat, // an action card played on a next player close to winning: 1 / their cards
+    feature_penalty_threat, // a Draw-2 or Draw-4 played on a next player close to winning: 1 / their cards
+    feature_leader_threat, // any card played while some opponent is close to winning: 1 / the fewest cards held
+    feature_follow_up, // something left in hand can be played on the card the move leaves on top
+    HEURISTIC_FEATURES
+};
+
+/**
+ * Struct: HeuristicWeights
+ * Description:
+ * One weight per HEURISTIC_FEATURE. The defaults are a hand-made start: keep
+ * the colour held most, hold wilds back until the hand is small, and save
+ * action cards for a next player who is about to win.
+ */
+struct HeuristicWeights {
+    double w[HEURISTIC_FEATURES];
+
+    HeuristicWeights() {
+        w[feature_draw] = -1.0;
+        w[feature_color_share] = 1.0;
+        w[feature_color_change] = -0.2;
+        w[feature_wild] = -1.0;
+        w[feature_wild_late] = 1.0;
+        w[feature_action] = 0.2;
+        w[feature_action_threat] = 1.0;
+        w[feature_penalty_threat] = 1.0;
+        w[feature_leader_threat] = 0.0;
+        w[feature_follow_up] = 0.5;
+    }
+};
+
+inline const char* feature_name(int feature) {
+    static const char* names[HEURISTIC_FEATURES] = {"draw", "color_share", "color_change", "wild", "wild_late",
+        "action", "action_threat", "penalty_threat", "leader_threat", "follow_up"};
+    return names[feature];
+}
+
+/**
+ * Class: HeuristicBot
+ * Description:
+ * Plays the legal move with the highest weighted score. Every distinct
+ * playable card is scored once (a wild once per colour it may name) straight
+ * from the hand's playable mask, and drawing is scored as a move of its own,
+ * so a decision costs a few dozen multiply-adds and never allocates. Ties go
+ * to the first move scored. The features read only what the player to move
+ * can see: its own hand, the card on top and how many cards every seat holds.
+ *
+ * Functionality:
+ * - `choose`: Gets the move to play in the current position.
+ * - `features`: Fills in the features of playing a card, naming col for a wild.
+ */
+class HeuristicBot {
+public:
+
+    explicit HeuristicBot(const HeuristicWeights& weights = HeuristicWeights()) : weights(weights) {
+    }
+
+    template <class Rules, class Events>
+    Move choose(const BasicEngine<Rules, Events>& engine) const {
+        const player& hand = engine.get_player(engine.get_turn());
+        Table table = read_table(engine);
+        double f[HEURISTIC_FEATURES];
+
+        if (engine.is_drawn_pending()) {
+            // the drawn card is never wild here, keeping it scores like drawing
+            features(hand, engine.get_played_card(), table, engine.get_drawn_card(), engine.get_drawn_card().color(), f);
+            return score(f) > weights.w[feature_draw] ? Move(play_drawn) : Move(keep_drawn);
+        }
+
+        Move best(draw_card);
+        double best_score = weights.w[feature_draw];
+        PlayableMask mask = engine.playable_mask();
+        for (int word = 0; word < 2; word++) {
+            for (uint64_t bits = mask.bits[word]; bits != 0; bits &= bits - 1) {
+                card temp = player::from_code(word * 64 + __builtin_ctzll(bits));
+                bool is_wild = temp.color() == wild;
+                for (int col = is_wild ? red : temp.color(); col <= (is_wild ? yellow : temp.color()); col++) {
+                    features(hand, engine.get_played_card(), table, temp, static_cast<COLOR> (col), f);
+                    double value = score(f);
+                    if (value > best_score) {
+                        best_score = value;
+                        best = Move(play_card, hand.index_of(temp), is_wild ? static_cast<COLOR> (col) : wild);
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+    // What the bot reads about the other seats
+
+    struct Table {
+        int next_cards; // cards held by the seat that plays next in the current direction
+        int fewest_cards; // fewest cards held by any opponent
+    };
+
+    // Function to fill f with the features of playing temp_card from hand on top, leaving col on top
+
+    static void features(const player& hand, card top, const Table& table, card temp_card, COLOR col, double* f) {
+        int size = hand.get_size();
+        int left = size - 1;
+        int number = temp_card.number();
+        bool is_wild = temp_card.color() == wild;
+        int same_color = hand.color_count(col) - (is_wild ? 0 : 1);
+
+        f[feature_draw] = 0;
+        f[feature_color_share] = left > 0 ? (double) same_color / left : 1;
+        f[feature_color_change] = col != top.color() ? 1 : 0;
+        f[feature_wild] = is_wild ? 1 : 0;
+        f[feature_wild_late] = is_wild ? 1.0 / size : 0;
+        bool action = number == SKIP || number == REVERSE || number == DRAW_TWO;
+        double next_threat = 1.0 / (table.next_cards > 0 ? table.next_cards : 1);
+        f[feature_action] = action ? 1 : 0;
+        f[feature_action_threat] = action ? next_threat : 0;
+        f[feature_penalty_threat] = number == DRAW_TWO || number == WILD_DRAW_FOUR ? next_threat : 0;
+        f[feature_leader_threat] = 1.0 / (table.fewest_cards > 0 ? table.fewest_cards : 1);
+
+        // the last copy of the card leaves the hand with it
+        PlayableMask after = hand.playable_mask(card(number, col));
+        if (hand.count(temp_card) == 1) {
+            int code = temp_card.get_code();
+            after.bits[code >> 6] &= ~(1ULL << (code & 63));
+        }
+        f[feature_follow_up] = (after.bits[0] | after.bits[1]) != 0 ? 1 : 0;
+    }
+
+    const HeuristicWeights& get_weights() const {
+        return weights;
+    }
+
+private:
+    HeuristicWeights weights;
+
+    double score(const double* f) const {
+        double value = 0;
+        for (int i = 0; i < HEURISTIC_FEATURES; i++) {
+            value += weights.w[i] * f[i];
+        }
+        return value;
+    }
+
+    template <class Engine>
+    static Table read_table(const Engine& engine) {
+        Table table;
+        int turn = engine.get_turn();
+        table.next_cards = engine.get_player(engine.get_seating().peek_next()).get_size();
+        table.fewest_cards = DECK_SIZE * MAX_DECKS;
+        for (int i = 0; i < engine.get_amount_players(); i++) {
+            int cards = engine.get_player(i).get_size();
+            if (i != turn && cards < table.fewest_cards) {
+                table.fewest_cards = cards;
+            }
+        }
+        return table;
+    }
+};
+
+#endif /* HEURISTIC_BOT_H */
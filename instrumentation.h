@@ -0,0 +1,244 @@
+/*
+ * File:   instrumentation.h
+ *
+ * Built-in counters and phase timers for the game loop, with a JSON summary
+ * and a Chrome trace-event export. Everything here is compiled out unless
+ * UNO_INSTRUMENT is defined (make INSTRUMENT=1).
+ */
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <cstdint>
+
+enum COUNTER {
+    counter_turns, counter_draws, counter_draw_two, counter_draw_four, counter_reshuffles, counter_invalid_moves,
+    COUNTERS
+};
+
+enum PHASE {
+    phase_deal, phase_select, phase_apply, phase_reshuffle, phase_render,
+    PHASES
+};
+
+#ifdef UNO_INSTRUMENT
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#define TRACE_EVENTS_PER_THREAD 100000 // later events of a thread are counted but not kept
+
+#define INSTR_CONCAT2(a, b) a##b
+#define INSTR_CONCAT(a, b) INSTR_CONCAT2(a, b)
+#define INSTR_COUNT(counter) Instrumentation::count(counter)
+#define INSTR_PHASE(phase) PhaseTimer INSTR_CONCAT(instr_phase_, __LINE__)(phase)
+
+inline const char* counter_name(COUNTER counter) {
+    static const char* names[COUNTERS] = {"turns", "draws", "forced_draw_two", "forced_draw_four", "reshuffles", "invalid_moves"};
+    return names[counter];
+}
+
+inline const char* phase_name(PHASE phase) {
+    static const char* names[PHASES] = {"deal", "move_selection", "apply", "reshuffle", "render"};
+    return names[phase];
+}
+
+struct TraceEvent {
+    uint64_t start_ns;
+    uint32_t duration_ns;
+    uint8_t phase;
+};
+
+/**
+ * Everything one thread has recorded. Only the owning thread writes to it,
+ * and every block is allocated on its own and aligned to a cache line, so
+ * threads never write to a shared line while counting.
+ */
+struct alignas(64) ThreadStats {
+    uint64_t counters[COUNTERS];
+    uint64_t phase_ns[PHASES];
+    uint64_t phase_calls[PHASES];
+    uint64_t dropped_events; // phases timed but left out of the trace, which was full
+    int thread_index;
+    std::vector<TraceEvent> trace;
+};
+
+/**
+ * Class: Instrumentation
+ * Description:
+ * The registry of every thread's ThreadStats. A thread registers on its
+ * first event (the only time a lock is taken) and keeps a thread_local
+ * pointer to its block from then on, so counting is one increment and timing
+ * a phase is two clock reads. Blocks outlive their threads, so results can be
+ * exported once a pool has finished. Exporting while threads still record
+ * reads counters that may be mid-update.
+ *
+ * Phase times are inclusive: a reshuffle inside a step counts towards both
+ * apply and reshuffle.
+ *
+ * Functionality:
+ * - `count`: Adds one to a counter of the calling thread.
+ * - `now_ns`: Nanoseconds since the first event of the process.
+ * - `record_phase`: Adds one timed phase of the calling thread.
+ * - `write_summary`: Writes totals and per-thread counters, times and dropped trace events as JSON.
+ * - `write_trace`: Writes every kept phase as Chrome trace events (chrome://tracing, Perfetto).
+ * - `reset`: Zeroes every thread's counters and drops the traces.
+ */
+class Instrumentation {
+public:
+
+    static void count(COUNTER counter) {
+        local().counters[counter]++;
+    }
+
+    static uint64_t now_ns() {
+        static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    static void record_phase(PHASE phase, uint64_t start_ns, uint64_t end_ns) {
+        ThreadStats& stats = local();
+        stats.phase_ns[phase] += end_ns - start_ns;
+        stats.phase_calls[phase]++;
+        if (stats.trace.size() < TRACE_EVENTS_PER_THREAD) {
+            stats.trace.push_back(TraceEvent{start_ns, (uint32_t) (end_ns - start_ns), (uint8_t) phase});
+        } else {
+            stats.dropped_events++;
+        }
+    }
+
+    static void write_summary(std::ostream& out) {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        std::vector<std::unique_ptr<ThreadStats>>& threads = registry();
+        uint64_t counters[COUNTERS] = {};
+        uint64_t phase_ns[PHASES] = {};
+        uint64_t phase_calls[PHASES] = {};
+        uint64_t dropped_events = 0;
+        for (const std::unique_ptr<ThreadStats>& stats : threads) {
+            dropped_events += stats->dropped_events;
+            for (int c = 0; c < COUNTERS; c++) {
+                counters[c] += stats->counters[c];
+            }
+            for (int p = 0; p < PHASES; p++) {
+                phase_ns[p] += stats->phase_ns[p];
+                phase_calls[p] += stats->phase_calls[p];
+            }
+        }
+
+        out << "{" << std::endl << "  \"totals\": ";
+        write_block(out, counters, phase_ns, phase_calls, dropped_events);
+        out << "," << std::endl << "  \"threads\": [" << std::endl;
+        for (size_t i = 0; i < threads.size(); i++) {
+            out << "    ";
+            write_block(out, threads[i]->counters, threads[i]->phase_ns, threads[i]->phase_calls, threads[i]->dropped_events);
+            out << (i + 1 < threads.size() ? "," : "") << std::endl;
+        }
+        out << "  ]" << std::endl << "}" << std::endl;
+    }
+
+    static void write_trace(std::ostream& out) {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [" << std::endl;
+        bool first = true;
+        for (const std::unique_ptr<ThreadStats>& stats : registry()) {
+            out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << stats->thread_index;
+            out << ", \"args\": {\"name\": \"worker " << stats->thread_index << "\"}}";
+            first = false;
+            for (const TraceEvent& event : stats->trace) {
+                out << ",\n{\"name\": \"" << phase_name(static_cast<PHASE> (event.phase)) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": ";
+                out << stats->thread_index << ", \"ts\": " << event.start_ns / 1000.0 << ", \"dur\": " << event.duration_ns / 1000.0 << "}";
+            }
+        }
+        out << std::endl << "]}" << std::endl;
+    }
+
+    static void reset() {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        for (const std::unique_ptr<ThreadStats>& stats : registry()) {
+            clear(*stats);
+        }
+    }
+
+private:
+
+    static ThreadStats& local() {
+        thread_local ThreadStats* stats = NULL;
+        if (stats == NULL) {
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            std::vector<std::unique_ptr<ThreadStats>>& threads = registry();
+            threads.push_back(std::unique_ptr<ThreadStats>(new ThreadStats()));
+            stats = threads.back().get();
+            stats->thread_index = threads.size() - 1;
+            // reserved up front, so recording never allocates once a thread is registered
+            stats->trace.reserve(TRACE_EVENTS_PER_THREAD);
+            clear(*stats);
+        }
+        return *stats;
+    }
+
+    static void clear(ThreadStats& stats) {
+        for (int c = 0; c < COUNTERS; c++) {
+            stats.counters[c] = 0;
+        }
+        for (int p = 0; p < PHASES; p++) {
+            stats.phase_ns[p] = 0;
+            stats.phase_calls[p] = 0;
+        }
+        stats.dropped_events = 0;
+        stats.trace.clear();
+    }
+
+    static void write_block(std::ostream& out, const uint64_t* counters, const uint64_t* phase_ns, const uint64_t* phase_calls,
+            uint64_t dropped_events) {
+        out << "{\"counters\": {";
+        for (int c = 0; c < COUNTERS; c++) {
+            out << (c ? ", " : "") << "\"" << counter_name(static_cast<COUNTER> (c)) << "\": " << counters[c];
+        }
+        out << "}, \"phases\": {";
+        for (int p = 0; p < PHASES; p++) {
+            out << (p ? ", " : "") << "\"" << phase_name(static_cast<PHASE> (p)) << "\": {\"ns\": " << phase_ns[p];
+            out << ", \"calls\": " << phase_calls[p] << "}";
+        }
+        out << "}, \"dropped_trace_events\": " << dropped_events << "}";
+    }
+
+    static std::vector<std::unique_ptr<ThreadStats>>& registry() {
+        static std::vector<std::unique_ptr<ThreadStats>> threads;
+        return threads;
+    }
+
+    static std::mutex& registry_mutex() {
+        static std::mutex lock;
+        return lock;
+    }
+};
+
+/**
+ * Times the scope it lives in as one phase, see INSTR_PHASE.
+ */
+class PhaseTimer {
+public:
+
+    explicit PhaseTimer(PHASE phase) : phase(phase), start_ns(Instrumentation::now_ns()) {
+    }
+
+    ~PhaseTimer() {
+        Instrumentation::record_phase(phase, start_ns, Instrumentation::now_ns());
+    }
+
+private:
+    PHASE phase;
+    uint64_t start_ns;
+};
+
+#else
+
+#define INSTR_COUNT(counter) ((void) 0)
+#define INSTR_PHASE(phase) ((void) 0)
+
+#endif
+
+#endif /* INSTRUMENTATION_H */
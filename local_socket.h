@@ -0,0 +1,229 @@
+/*
+ * File:   local_socket.h
+ *
+ * Unix-domain and loopback TCP sockets for the game server and its clients,
+ * and the line protocol they speak.
+ */
+
+#ifndef LOCAL_SOCKET_H
+#define LOCAL_SOCKET_H
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * The protocol is one text line per message. A client starts with
+ *
+ *   JOIN <players> <bots>   take a seat at a table of <players> seats, <bots> of them played by the server
+ *   STATS                   answered with STATS <server cpu microseconds> <open tables> <connections>
+ *
+ * and, once its table is full, the server sends
+ *
+ *   START <players> <seat>
+ *   MOVE <n> <played card> <forced draw> <hand size> <card> ...  answer <n> and a hand position, or -1 to draw
+ *   COLOR <n>                                                    answer <n> and red, green, blue or yellow
+ *   DRAWN <n> <card>                                             answer <n> and y to play the drawn card or n to keep it
+ *   OK | INVALID                                                 the answer was applied or refused
+ *   TIMEOUT PLAY <card> [<colour>] | TIMEOUT DRAW | TIMEOUT KEEP  no answer in time, the server made this move
+ *   END <winner seat>                                            -1 when the game hit MAX_TURNS
+ *
+ * <n> numbers the prompts of a connection, one more for every prompt. An
+ * answer that does not start with the number of the prompt being waited for,
+ * like a late answer to a prompt that timed out, is dropped, so a slow client
+ * never answers the wrong question. Cards travel as their packed code
+ * (card::get_code) and seats count from 0. After END the client may JOIN
+ * again on the same connection.
+ */
+#define PROTOCOL_MAX_LINE 1024 // longer lines close the connection
+
+// Function to lift the open file limit to its hard maximum, every connection takes one descriptor
+
+inline void raise_file_limit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+inline bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/**
+ * Class: LocalAddress
+ * Description:
+ * Where the server listens: "unix:<path>" for a Unix-domain socket or
+ * "tcp:<port>" for a TCP port on 127.0.0.1. Never binds to anything but
+ * loopback.
+ *
+ * Functionality:
+ * - `parse`: Reads an address, returns false when it has neither form.
+ * - `listen_on`: Creates the listening socket, removing a stale socket file first.
+ * - `connect_to`: Opens a blocking connection.
+ * - Both return -1 and print the reason when the socket call fails.
+ */
+class LocalAddress {
+public:
+
+    LocalAddress() : port(0) {
+    }
+
+    bool parse(const std::string& text) {
+        if (text.compare(0, 5, "unix:") == 0 && text.size() > 5 && text.size() - 5 < sizeof (sockaddr_un::sun_path)) {
+            path = text.substr(5);
+            port = 0;
+            return true;
+        }
+        if (text.compare(0, 4, "tcp:") == 0) {
+            port = atoi(text.c_str() + 4);
+            path.clear();
+            return port > 0 && port < 65536;
+        }
+        return false;
+    }
+
+    int listen_on() const {
+        int fd = socket(is_unix() ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            perror("socket");
+            return -1;
+        }
+        if (is_unix()) {
+            unlink(path.c_str());
+        } else {
+            int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof (on));
+        }
+        sockaddr_storage address;
+        socklen_t length = fill(address);
+        if (bind(fd, (sockaddr*) & address, length) < 0 || listen(fd, SOMAXCONN) < 0) {
+            perror("bind");
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    int connect_to() const {
+        int fd = socket(is_unix() ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            perror("socket");
+            return -1;
+        }
+        sockaddr_storage address;
+        socklen_t length = fill(address);
+        if (connect(fd, (sockaddr*) & address, length) < 0) {
+            perror("connect");
+            close(fd);
+            return -1;
+        }
+        if (!is_unix()) {
+            // every message is one small line that someone waits for
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof (on));
+        }
+        return fd;
+    }
+
+    bool is_unix() const {
+        return port == 0;
+    }
+
+private:
+    std::string path;
+    int port;
+
+    socklen_t fill(sockaddr_storage& address) const {
+        std::memset(&address, 0, sizeof (address));
+        if (is_unix()) {
+            sockaddr_un& un = (sockaddr_un&) address;
+            un.sun_family = AF_UNIX;
+            std::strcpy(un.sun_path, path.c_str());
+            return sizeof (sockaddr_un);
+        }
+        sockaddr_in& in = (sockaddr_in&) address;
+        in.sin_family = AF_INET;
+        in.sin_port = htons(port);
+        in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return sizeof (sockaddr_in);
+    }
+};
+
+/**
+ * Class: LineBuffer
+ * Description:
+ * Bytes read from a socket, handed out one complete line at a time. Consumed
+ * bytes are dropped lazily, so a burst of lines costs one compaction.
+ *
+ * Functionality:
+ * - `fill`: Reads everything the socket has, returns false on end of file or error.
+ * - `next_line`: Takes the next complete line without its newline.
+ * - `has_line`: Checks for a complete line.
+ * - `overflowed`: True when a line grew past PROTOCOL_MAX_LINE.
+ */
+class LineBuffer {
+public:
+
+    LineBuffer() : start(0) {
+    }
+
+    bool fill(int fd) {
+        char chunk[4096];
+        while (true) {
+            ssize_t n = read(fd, chunk, sizeof (chunk));
+            if (n > 0) {
+                data.append(chunk, n);
+            } else if (n == 0) {
+                return false;
+            } else {
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            }
+            if (n < (ssize_t) sizeof (chunk)) {
+                return true;
+            }
+        }
+    }
+
+    bool has_line() const {
+        return data.find('\n', start) != std::string::npos;
+    }
+
+    bool next_line(std::string& line) {
+        size_t end = data.find('\n', start);
+        if (end == std::string::npos) {
+            return false;
+        }
+        size_t length = end > start && data[end - 1] == '\r' ? end - start - 1 : end - start;
+        line.assign(data, start, length);
+        start = end + 1;
+        if (start == data.size()) {
+            data.clear();
+            start = 0;
+        } else if (start > data.size() / 2) {
+            data.erase(0, start);
+            start = 0;
+        }
+        return true;
+    }
+
+    bool overflowed() const {
+        return data.size() - start > PROTOCOL_MAX_LINE && !has_line();
+    }
+
+private:
+    std::string data;
+    size_t start; // first byte not handed out yet
+};
+
+#endif /* LOCAL_SOCKET_H */
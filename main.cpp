@@ -1,960 +1,1355 @@
-/*
- * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
- * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/main.cc to edit this template
- */
-
-/*
- * File:   main.cpp
- * Author: alvin
- *
- * Created on November 10, 2023, 10:46 PM
- */
-
-#include <cstdlib>
-
-using namespace std;
-
-#include <ostream>
-#include<iostream>
-#include <string>
-#include <cstdlib>
-#include <limits>
-#include <stack>
-#include <queue>
-#include <list>
-#include <algorithm>
-#include <unordered_map>
-#include <vector>
-using namespace std;
-
-/**
- * Project Title: Simple UNO Game Simulation
- *
- * Description:
- * This program simulates a simple UNO card game. UNO is a popular
- * shedding-type card game that is played with a specially printed deck.
- * The deck consists of cards of different colors and values, including
- * special cards that introduce unique actions.
- *
- * Rules:
- * - The game is played with a deck of 108 cards, divided into four colors:
- *   red, green, blue, and yellow. Each color has cards numbered from 0 to 9,
- *   along with special action cards such as "Draw Two," "Skip," and "Reverse."
- * - Additionally, there are two types of Wild cards: "Wild" and "Wild Draw Four."
- * - Players take turns playing a card that matches the top card of the discard
- *   pile in either number or color.
- * - Special action cards have unique effects, like forcing the next player to draw cards,
- *   skipping a player's turn, or reversing the order of play.
- * - Wild cards allow the player to choose the next color.
- * - The first player to play all their cards wins the game.
- *
- * Mechanism:
- * The program models the UNO game with a deck of cards and provides basic
- * functionality such as shuffling the deck, drawing cards, and simulating the
- * game flow.
- */
-
-#define PRINT_ALL_PLAYERS 0
-#define TEMP_DECK 1
-#define TURN 2
-#define TEST -1
-
-#define DECK_SIZE 108
-
-enum COLOR {
-    wild, red, green, blue, yellow
-};
-
-class card {
-public:
-    int number; // 0-9 numbers, +2, skip, reverse, all color, +4 (all color)
-    COLOR color; // 5 colors: red, green, blue, yellow, and no color
-
-    /**
-     * Equality operator.
-     * @param other Other card to check equality with. (can be put as the next card)
-     */
-    bool operator==(card const& other) const {
-        return number == other.number || color == other.color || color == wild || other.color == wild;
-
-    }
-
-    /**
-     * Inequality operator.
-     * @param other Other card to check inequality with.
-     */
-    bool operator!=(card const& other) const {
-        return !(*this == other);
-    }
-
-    card() : number(0), color(wild) {
-
-    }
-
-    card(int num, COLOR col) : number(num), color(col) {
-
-    }
-};
-
-/**
- * Stream operator that allows a card to be written to standard streams
- * (like cout).
- *
- * @param out Stream to write to.
- * @param temp_card to write to the stream.
- */
-std::ostream& operator<<(std::ostream& out, card const& temp_card) {
-    out << "Number:";
-    switch (temp_card.number) {
-        case 10:
-            out << "DRAW-2";
-            break;
-        case 11:
-            out << "SKIP";
-            break;
-        case 12:
-            out << "REVERSE";
-            break;
-        case 13:
-            out << "WILD";
-            break;
-        case 14:
-            out << "DRAW-4-WILD";
-            break;
-        default:
-            out << (int) temp_card.number;
-            break;
-    }
-
-    out << "   Color:";
-    switch (temp_card.color) {
-        case wild:
-            out << "wild";
-            break;
-        case red:
-            out << "red";
-            break;
-        case green:
-            out << "green";
-            break;
-        case blue:
-            out << "blue";
-            break;
-        case yellow:
-            out << "yellow";
-            break;
-        default:
-            out << "N/A";
-            break;
-    }
-    return out;
-}
-
-/**
- * Class: deck
- * Description:
- * The `deck` class represents a deck of UNO cards. It is derived from the `card` class
- * and includes functionalities to manage and manipulate the deck, such as shuffling,
- * drawing cards, and checking the status of the deck.
- *
- * Functionality:
- * - `isDeckEmpty`: Checks if the deck is empty.
- * - `reshuffle`: Reshuffles the entire deck.
- * - `addCardToBottom`: Adds a card to the bottom of the deck, simulating a queue-like behavior.
- * - `drawMultiple`: Draws a specific number of cards from the top of the deck.
- * - `removeCard`: Removes a specific card from the deck, if present.
- * - `create`: Populates the deck with UNO cards based on the game rules.
- * - `print_deck`: Prints the current state of the deck to the console.
- * - `get_size`: Gets the current size of the deck.
- * - `shuffle`: Shuffles the deck using the Fisher-Yates algorithm.
- * - `draw`: Draws the top card from the deck.
- * - `add_card`: Adds a card to the deck.
- * - `quick_shuffle`: Shuffles the deck quickly using a simplified algorithm.
- * - `copy`: Copies the content of another deck.
- * - `clear`: Clears the deck, releasing allocated memory.
- */
-
-class deck : public card {
-private:
-    card* ptr_deck;
-    int size;
-
-public:
-
-    deck() {
-        ptr_deck = new card[DECK_SIZE];
-        size = 0;
-    }
-
-    bool isDeckEmpty() const {
-        return size <= 0;
-    }
-
-    // Function to reshuffle the entire deck
-
-    void reshuffle() {
-        // Use std::random_shuffle to shuffle the deck
-        std::random_shuffle(ptr_deck, ptr_deck + size);
-    }
-
-    // Function to add a card to the bottom of the deck (like putting it at the end of the queue)
-
-    void addCardToBottom(card temp_card) {
-        if (size < DECK_SIZE) {
-            // Use a queue-like behavior to add at the end
-            std::rotate(ptr_deck, ptr_deck + 1, ptr_deck + size + 1);
-            ptr_deck[size - 1] = temp_card;
-            size++;
-        }
-    }
-
-    // Function to draw a specific number of cards from the deck
-
-    std::list<card> drawMultiple(int numCards) {
-        std::list<card> drawnCards;
-        for (int i = 0; i < numCards && size > 0; ++i) {
-            drawnCards.push_back(ptr_deck[size - 1]);
-            size--;
-        }
-        return drawnCards;
-    }
-
-    // Function to remove a specific card from the deck (if present)
-
-    bool removeCard(const card& targetCard) {
-        auto iter = std::find(ptr_deck, ptr_deck + size, targetCard);
-        if (iter != ptr_deck + size) {
-            std::rotate(iter, iter + 1, ptr_deck + size);
-            size--;
-            return true;
-        }
-        return false;
-    }
-
-    void create() {
-        int num = 0;
-
-        // card rank 0
-        for (int col = 1; col <= 4; col++) {
-            ptr_deck[size].number = num;
-            ptr_deck[size].color = static_cast<COLOR> (col);
-            size++;
-        }
-
-        // card rank 1 till 9 , "draw-two", "skip", "reverse"
-        for (num = 1; num <= 12; num++) {
-            for (int x = 0; x < 2; x++) {
-                for (int col = 1; col <= 4; col++) {
-                    ptr_deck[size].number = num;
-                    ptr_deck[size].color = static_cast<COLOR> (col);
-                    size++;
-                }
-            }
-        }
-
-        // card "wild", "wild-draw-four"
-        for (num = 13; num <= 14; num++) {
-            for (int x = 0; x < 4; x++) {
-                ptr_deck[size].number = num;
-                ptr_deck[size].color = wild;
-                size++;
-            }
-        }
-    }
-
-    void print_deck() {
-        for (int i = 0; i < size; i++) {
-            cout << i << ": " << ptr_deck[i] << endl;
-        }
-    }
-
-    int get_size() {
-        return size;
-    }
-
-    deck(const deck& other) {
-        copy(other);
-    }
-
-    const deck& operator=(const deck& other) {
-        if (this != &other) {
-            clear();
-            copy(other);
-        }
-        return *this;
-    }
-
-    ~deck() {
-        clear();
-    }
-
-    void shuffle() {
-        card* temp_deck = new card[size];
-        for (int i = 0; i < size; i++) {
-            temp_deck[i] = ptr_deck[i];
-        }
-
-        int temp_size = size;
-        int temp_pos;
-        int pos;
-        for (int i = 0; i < size; i++) {
-            srand(time(NULL));
-            pos = rand() % temp_size;
-            ptr_deck[i] = temp_deck[pos];
-
-            temp_size--;
-            for (temp_pos = pos; temp_pos < temp_size; temp_pos++) {
-                temp_deck[temp_pos] = temp_deck[temp_pos + 1];
-            }
-        }
-
-        delete[] temp_deck;
-    }
-
-    card draw() {
-        if (size <= 0) {
-            std::cout << "Deck is empty!" << std::endl;
-
-            return card();
-        }
-        card temp_card = ptr_deck[size - 1];
-        size--;
-        return temp_card;
-    }
-
-    int add_card(card temp_card) {
-        if (size < DECK_SIZE) {
-            ptr_deck[size] = temp_card;
-            size++;
-            return 0;
-        } else
-            return -1;
-    }
-
-    void quick_shuffle() {
-        int pos;
-        int temp_size = size - 1;
-        card temp_card;
-        while (temp_size > 0) {
-            srand(time(NULL));
-            pos = rand() % temp_size;
-            temp_card = ptr_deck[temp_size];
-            ptr_deck[temp_size] = ptr_deck[pos];
-            ptr_deck[pos] = temp_card;
-            temp_size--;
-        }
-    }
-
-    void copy(const deck& other) {
-        size = other.size;
-        ptr_deck = new card[size];
-        for (int i = 0; i < size; i++) {
-            ptr_deck[i] = other.ptr_deck[i];
-        }
-    }
-
-    void clear() {
-        delete[]ptr_deck;
-        ptr_deck = NULL;
-        size = 0;
-    }
-
-
-};
-
-class Graph {
-public:
-    std::unordered_map<player*, std::vector<player*>, PlayerHash> adjacencyList;
-
-    // Function to add an edge between two players
-
-    void addEdge(player* player1, player* player2) {
-        adjacencyList[player1].push_back(player2);
-        adjacencyList[player2].push_back(player1);
-    }
-
-    // Function to print the connections in the graph
-
-    void printGraph() {
-        for (const auto& entry : adjacencyList) {
-            cout << "PLAYER " << (entry.first - play_array) + 1 << " is connected to: ";
-            for (const auto& connectedPlayer : entry.second) {
-                cout << "PLAYER " << (connectedPlayer - play_array) + 1 << " ";
-            }
-            cout << endl;
-        }
-    }
-};
-
-struct PlayerHash {
-
-    std::size_t operator()(const player* p) const {
-        return reinterpret_cast<std::size_t> (p);
-    }
-};
-
-/**
- * Class: player
- * Description:
- * The `player` class represents a player in the UNO game. It manages the player's hand,
- * which is a collection of UNO cards. The class provides functionalities to add, remove,
- * and manipulate cards in the player's hand. Each player object maintains a linked list
- * of cards, allowing for dynamic size adjustments.
- *
- * Purpose and Reasoning:
- * In the UNO game, players need a way to hold and manage their cards. The `player` class
- * serves as a container for the player's hand, allowing easy addition, removal, and
- * manipulation of cards. The linked list structure is chosen for the hand to handle
- * dynamic size changes efficiently.
- *
- * Key Functionality:
- * - `hand_add`: Adds a card to the player's hand.
- * - `hand_remove`: Removes a card from the player's hand at a specified position.
- * - `print`: Displays the cards in the player's hand to the console.
- * - `get_size`: Gets the current size of the player's hand.
- * - `peek`: Retrieves a card from the player's hand without removing it.
- *
- * Private Nested Class: card_elem
- * This class represents an element in the linked list, holding a card and a pointer to
- * the next element. It is a private nested class to encapsulate the linked list
- * implementation details from the external users of the `player` class.
- *
- * Private Members:
- * - `head`: Pointer to the first element in the linked list.
- * - `size`: Current size of the player's hand.
- *
- * Member Functions:
- * - `copy`: Copies the content of another player's hand.
- * - `clear`: Clears the player's hand, releasing allocated memory.
- *
- *  This class is designed to be part of a larger UNO game implementation,
- * and it works in conjunction with the `card` class and potentially a `deck` class.
- */
-
-class player {
-public:
-
-    player() {
-        head = NULL;
-        size = 0;
-    }
-
-    player(const player& other) {
-        copy(other);
-    }
-
-    const player& operator=(const player& other) {
-        if (this != &other) {
-            clear();
-            copy(other);
-        }
-
-        return *this;
-    }
-
-    ~player() {
-        clear();
-    }
-
-    // Function to add a card to the player's hand
-
-    void hand_add(card temp_card) {
-        card_elem* temp_ptr;
-        temp_ptr = new card_elem();
-        temp_ptr->data = temp_card;
-        temp_ptr->next = head;
-        head = temp_ptr;
-        size++;
-    }
-
-    // Function to remove a card from the player's hand at a specified position
-
-    card hand_remove(int pos) {
-        if (pos < 0 || pos >= size) {
-            return card();
-        }
-
-        card_elem* prev_ptr = head;
-        card_elem* target = prev_ptr->next;
-        card temp_card;
-        int temp_pos = pos;
-
-        if (pos == 0) {
-            temp_card = head->data;
-            head = head->next;
-            delete prev_ptr;
-            size--;
-            return temp_card;
-        }
-
-        while (temp_pos > 1) {
-            prev_ptr = prev_ptr->next;
-            target = prev_ptr->next;
-            temp_pos--;
-        }
-
-        prev_ptr->next = target->next;
-        temp_card = target->data;
-        delete target;
-        size--;
-        return temp_card;
-    }
-
-
-    // Function to print the cards in the player's hand to the console
-
-    void print() const {
-        int temp_size = size;
-        int i = 0;
-        card_elem* temp_ptr = head;
-        while (temp_size > 0) {
-            std::cout << i + 1 << ":  " << temp_ptr->data << std::endl;
-            temp_ptr = temp_ptr->next;
-            i++;
-            temp_size--;
-        }
-    }
-    // Function to get the current size of the player's hand
-
-    int get_size() const {
-        return size;
-    }
-
-    // Function to peek at a card in the player's hand without removing it
-
-    card peek(int pos) const {
-        int temp_pos = pos;
-        card_elem* temp_elem = head;
-        while (temp_pos > 0) {
-            temp_elem = temp_elem->next;
-            temp_pos--;
-        }
-
-        return temp_elem->data;
-    }
-
-private:
-    // Nested class representing an element in the linked list
-
-    class card_elem {
-    public:
-
-        card_elem() {
-            next = NULL;
-        }
-        card data;
-        card_elem* next;
-    };
-
-    card_elem* head; // Pointer to the first element in the linked list
-    int size;
-
-    // Function to copy the content of another player's hand
-
-    void copy(const player& other) {
-        size = other.size;
-
-        if (size > 0) {
-            head = new card_elem();
-            head->data = other.head->data;
-        } else {
-            head = NULL;
-            return;
-        }
-
-        card_elem* other_ptr = other.head->next;
-        card_elem* temp_ptr;
-        card_elem* prev_ptr = head;
-        for (int i = 1; i < size; i++) {
-            temp_ptr = new card_elem();
-            prev_ptr->next = temp_ptr;
-            temp_ptr->data = other_ptr->data;
-            prev_ptr = temp_ptr;
-            temp_ptr = NULL;
-            other_ptr = other_ptr->next;
-        }
-    }
-    // Function to clear the player's hand, releasing allocated memory
-
-    void clear() {
-        card_elem* temp_ptr = head;
-        card_elem* next_ptr;
-        while (size > 0) {
-            next_ptr = temp_ptr->next;
-            delete temp_ptr;
-            temp_ptr = next_ptr;
-            size--;
-        }
-        head = NULL;
-    }
-};
-
-void confirm_turn(int x) {
-
-    cout << "Confirm Player" << x << " by typing " << "'" << x << "'" << " and pressing enter" << ": ";
-    int temp = 0;
-    while (temp != x) {
-        cin >> temp;
-    }
-}
-
-COLOR FromString(const string& str) {
-    if (str == "red")
-        return red;
-    else if (str == "green")
-        return green;
-    else if (str == "blue")
-        return blue;
-    else if (str == "yellow")
-        return yellow;
-    else
-        return wild;
-}
-
-// Function to check if a player has won the game recursively
-
-bool checkWinner(const player* play_array, int amount_players, int currentPlayerIndex) {
-    // Base case: player's hand is empty
-    if (play_array[currentPlayerIndex].get_size() == 0) {
-        cout << "PLAYER " << currentPlayerIndex + 1 << " has won the game." << endl;
-        return true;
-    }
-
-    // Recursive case: check the next player
-    int nextPlayerIndex = (currentPlayerIndex + 1) % amount_players;
-    return checkWinner(play_array, amount_players, nextPlayerIndex);
-
-
-}
-
-class TreeNode {
-public:
-    player* playerNode;
-    TreeNode* left;
-    TreeNode* right;
-
-    TreeNode(player* playerNode) : playerNode(playerNode), left(nullptr), right(nullptr) {
-    }
-};
-
-// Function to build a binary tree of players
-
-TreeNode* buildPlayerTree(player* play_array, int amount_players, int start, int end) {
-    if (start > end)
-        return nullptr;
-
-    int mid = (start + end) / 2;
-    TreeNode* root = new TreeNode(&play_array[mid]);
-    root->left = buildPlayerTree(play_array, amount_players, start, mid - 1);
-    root->right = buildPlayerTree(play_array, amount_players, mid + 1, end);
-
-    return root;
-}
-
-int main() {
-    std::unordered_map<player*, player, PlayerHash> playerHashTable;
-    Graph playerGraph;
-    while (!checkWinner(play_array, amount_players, turn % amount_players)) {
-        int amount_players;
-        int flag = 0;
-        while (flag == 0) {
-            cout << "Please enter amount of players: ";
-            cin >> amount_players;
-            if (amount_players >= 2 && amount_players <= 5) {
-                cout << amount_players << " players entering game .... " << endl;
-                flag = 1;
-                system("pause");
-                break;
-            } else {
-                cout << "invalid amount of players" << endl;
-            }
-        }
-
-        TreeNode* playerTree = buildPlayerTree(play_array, amount_players, 0, amount_players - 1);
-
-        /* create the components of the game */
-        /* creating deck */
-        deck main_deck;
-        main_deck.create();
-        main_deck.quick_shuffle();
-        /* creating player array */
-        player* play_array;
-        play_array = new player[amount_players];
-        /* distributing 7 starting cards to each player */
-        for (int i = 0; i < amount_players; i++) {
-            for (int k = 0; k < 7; k++) {
-                card temp_card;
-                temp_card = main_deck.draw();
-                play_array[i].hand_add(temp_card);
-            }
-        }
-        /* all cards that are played will go to temp_deck */
-        deck temp_deck;
-        /* create the first starting card, by drawing from deck */
-        card played_card;
-        card temp_card;
-        int card_flag = 0;
-        while (card_flag == 0) {
-            temp_card = main_deck.draw();
-            /* if first card is not wild, then okay*/
-            if (temp_card.color != wild) {
-                card_flag = 1;
-                played_card = temp_card;
-            }/* if first card is wild, redraw */
-            else {
-                temp_deck.add_card(temp_card);
-            }
-        }
-
-
-#if TEST == PRINT_ALL_PLAYERS
-        /*print out testing */
-        for (int i = 0; i < amount_players; i++) {
-            cout << "player: " << i + 1 << endl;
-            play_array[i].print();
-        }
-#endif
-        /* randomize who starts first */
-
-        srand(time(NULL));
-        int turn = rand() % amount_players;
-        cout << "PLAYER " << turn << " is randomly selected to play first" << endl;
-        confirm_turn(turn);
-
-        bool force_draw_bool = false;
-        int turn_flag = 1;
-        int win = 0;
-        /* keep playing until a player wins */
-        while (win == 0) {
-            // clear screen
-            system("cls");
-
-
-#if TEST == TEMP_DECK
-            temp_deck.print_deck();
-#endif
-
-            // Fixed error , at first created a new player each time , therefore did not update
-            // Have to use player pointer instead
-            player* curr_player = &play_array[turn % amount_players];
-
-
-            // checked for forced draw cards
-            cout << "PLAYER " << (turn % amount_players) + 1 << endl;
-
-            if (force_draw_bool) {
-                // checked for Draw-2
-                if (played_card.number == 10) {
-                    cout << "Forced Draw-2" << endl;
-                    card draw_2;
-                    for (int i = 0; i < 2; i++) {
-                        draw_2 = main_deck.draw();
-                        curr_player->hand_add(draw_2);
-                    }
-                }
-
-                // check for Draw-4
-                if (played_card.number == 14) {
-                    cout << "Forced Draw-4" << endl;
-                    card draw_4;
-                    for (int i = 0; i < 4; i++) {
-                        draw_4 = main_deck.draw();
-                        curr_player->hand_add(draw_4);
-                    }
-
-                }
-                force_draw_bool = false;
-            }
-
-
-            // print out the cards remaining for each player
-            cout << "Cards remaining for each player " << endl;
-            cout << "====================================" << endl;
-            for (int i = 0; i < amount_players; i++) {
-                cout << "PLAYER " << i + 1 << ": " << play_array[i].get_size() << "   ";
-            }
-            cout << endl;
-            // print out the temporary card
-            cout << "Played Card: " << played_card << endl;
-            // print out cards in player's hand
-            cout << "PLAYER " << (turn % amount_players) + 1 << endl;
-            cout << "====================================" << endl;
-
-            curr_player->print();
-            int check_flag = 0;
-            int index;
-            int size = curr_player->get_size();
-            // ask for which card to play into middle
-            while (check_flag == 0) {
-                cout << "which card do you want to play? " << endl;
-                cout << "If you want to draw a card please enter '-1' " << endl;
-
-                cin >> index;
-                //check if index is to draw a card
-                if (index == -1) {
-                    card draw_temp;
-                    draw_temp = main_deck.draw();
-                    cout << "DRAWN CARD: " << draw_temp << endl;
-                    if (draw_temp == played_card && draw_temp.color != wild) {
-
-                        int play_draw_flag = 0;
-                        while (play_draw_flag == 0) {
-
-                            string temp_play;
-                            cout << "Do you want to play the drawn card [y/n] : ";
-                            cin >> temp_play;
-                            if (temp_play == "y") {
-                                played_card = draw_temp;
-                                temp_deck.add_card(draw_temp);
-                                if (played_card.number >= 10 && played_card.number <= 14) {
-                                    force_draw_bool = true;
-                                }
-                                play_draw_flag = 1;
-                            }
-                            if (temp_play == "n") {
-                                curr_player->hand_add(draw_temp);
-                                play_draw_flag = 1;
-                            }
-
-
-                        }
-
-                    } else {
-                        curr_player->hand_add(draw_temp);
-                    }
-                    check_flag = 1;
-
-                }
-                //check if index is valid
-                if (index >= 0 && index < size) {
-                    // check if card is compatilbe with played card
-                    card temp = curr_player->peek(index);
-                    if (temp == played_card) {
-                        //remove from player's hand
-                        curr_player->hand_remove(index);
-                        // add to the discarded pile
-                        temp_deck.add_card(temp);
-                        // change the played card
-                        played_card = temp;
-                        // check if card is a wild card
-                        if (played_card.color == wild) {
-                            int check_color = 0;
-                            COLOR temp_color;
-                            string str_color;
-                            while (check_color == 0) {
-                                // ask for new color
-                                cout << "Please choose a color (red , green, blue, yellow) :";
-                                cin >> str_color;
-                                // change string to enum type COLOR
-                                temp_color = FromString(str_color);
-                                // check if valid color
-                                if (temp_color != wild) {
-                                    played_card.color = temp_color;
-                                    check_color = 1;
-                                } else {
-                                    cout << "invalid color" << endl;
-                                }
-
-                            }
-                        }
-                        if (played_card.number >= 10 && played_card.number <= 14) {
-                            force_draw_bool = true;
-                        }
-                        check_flag = 1;
-                    } else {
-                        cout << "card cannot be played " << endl;
-                    }
-                } else {
-                    cout << "invalid index " << endl;
-                }
-            }
-
-
-
-
-            // check if there is a winner, and break while loop
-            if (curr_player->get_size() == 0) {
-                win = 1;
-                cout << "PLAYER " << (turn % amount_players) + 1 << " has won the game." << endl;
-                break;
-            }
-
-            // check for action cards that influence the turn here
-            // skip case
-            if (played_card.number == 11 && force_draw_bool == true) {
-                if (turn_flag == 1)
-                    turn = turn + 2;
-                else
-                    turn = turn - 2;
-            }// reverse case
-            else if (played_card.number == 12 && force_draw_bool == true) {
-                // if only two players, behaves like a skip card
-                if (amount_players == 2) {
-                    turn = turn + 2;
-                } else {
-                    // changes the rotation of game (from CW to CCW or vice versa)
-                    if (turn_flag == 1) {
-                        turn_flag = -1;
-                        turn--;
-                    } else {
-                        turn_flag = 1;
-                        turn++;
-                    }
-
-                }
-            }// for other cards
-            else {
-                // depending on going Clockwise or CounterClockwise
-                if (turn_flag == 1)
-                    turn++;
-                else
-                    turn--;
-            }
-
-
-            system("cls");
-            // print out the cards remaining for each player
-            cout << "Cards remaining for each player: " << endl;
-            cout << "====================================" << endl;
-            for (int i = 0; i < amount_players; i++) {
-                cout << "PLAYER " << i + 1 << ": " << play_array[i].get_size() << "   ";
-            }
-            cout << endl;
-
-            cout << "====================================" << endl;
-
-            // print out the temporary card
-            cout << "Played Card: " << played_card << endl;
-            confirm_turn(turn % amount_players);
-
-
-            // when main deck is running out of cards
-            if (main_deck.get_size() < 10) {
-                // flush remaining cards from main to temp deck
-                for (int i = 0; i < main_deck.get_size(); i++) {
-                    temp_deck.add_card(main_deck.draw());
-                }
-                //recreate main_deck and shuffle it
-                main_deck = temp_deck;
-                main_deck.quick_shuffle();
-                // clear temp deck
-                temp_deck = deck();
-
-            }
-              for (int i = 0; i < amount_players; ++i) {
-                playerHashTable[&play_array[i]] = play_array[i];
-                playerGraph.addEdge(&play_array[i], &play_array[(i + 1) % amount_players]);
-            }
-
-            // Print the connections in the graph
-            cout << "Graph Connections:" << endl;
-            playerGraph.printGraph();
-
-        }
-
-    }
-
-
-
-    return 0;
-}
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/main.cc to edit this template
+ */
+
+/*
+ * File:   main.cpp
+ * Author: alvin
+ *
+ * Created on November 10, 2023, 10:46 PM
+ */
+
+#include <cstdlib>
+
+using namespace std;
+
+#include <ostream>
+#include<iostream>
+#include <string>
+#include <cstdlib>
+#include <limits>
+#include <stack>
+#include <queue>
+#include <list>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include "card.h"
+#include "deck.h"
+#include "player.h"
+#include "game_engine.h"
+#include "simulation_runner.h"
+#include "game_record.h"
+#include "mcts_bot.h"
+#include "endgame_solver.h"
+#include "batch_simulator.h"
+#include "instrumentation.h"
+#include "renderer.h"
+#include "card_tracker.h"
+#include "tournament.h"
+#include "bot_tuner.h"
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <new>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * Project Title: Simple UNO Game Simulation
+ *
+ * Description:
+ * This program simulates a simple UNO card game. UNO is a popular
+ * shedding-type card game that is played with a specially printed deck.
+ * The deck consists of cards of different colors and values, including
+ * special cards that introduce unique actions.
+ *
+ * Rules:
+ * - The game is played with a deck of 108 cards, divided into four colors:
+ *   red, green, blue, and yellow. Each color has cards numbered from 0 to 9,
+ *   along with special action cards such as "Draw Two," "Skip," and "Reverse."
+ * - Additionally, there are two types of Wild cards: "Wild" and "Wild Draw Four."
+ * - Players take turns playing a card that matches the top card of the discard
+ *   pile in either number or color.
+ * - Special action cards have unique effects, like forcing the next player to draw cards,
+ *   skipping a player's turn, or reversing the order of play.
+ * - Wild cards allow the player to choose the next color.
+ * - The first player to play all their cards wins the game.
+ *
+ * Mechanism:
+ * The program models the UNO game with a deck of cards and provides basic
+ * functionality such as shuffling the deck, drawing cards, and simulating the
+ * game flow.
+ */
+
+#define PRINT_ALL_PLAYERS 0
+#define TEMP_DECK 1
+#define TURN 2
+#define TEST -1
+
+#define MAX_HUMAN_PLAYERS 5
+
+/* every call to the global allocator is counted, --check-alloc uses it */
+static std::atomic<long long> global_allocations(0);
+
+void* operator new(std::size_t n) {
+    global_allocations++;
+    void* p = malloc(n == 0 ? 1 : n);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    free(p);
+}
+
+void confirm_turn(Renderer& renderer, int x) {
+
+    renderer.message("Confirm Player" + to_string(x) + " by typing '" + to_string(x) + "' and pressing enter: ");
+    renderer.flush();
+    int temp = 0;
+    while (temp != x) {
+        cin >> temp;
+    }
+}
+
+string drawn_text(card drawn) {
+    string text = "DRAWN CARD: ";
+    append_card(text, drawn);
+    return text;
+}
+
+// Function to describe the move a computer player is about to make
+
+string describe_move(const GameEngine& engine, const Move& move) {
+    string text = "PLAYER " + to_string(engine.get_turn() + 1) + " (computer) ";
+    if (move.type == play_card) {
+        card temp = engine.get_player(engine.get_turn()).peek(move.index);
+        text += "plays ";
+        append_card(text, temp);
+        if (temp.color() == wild) {
+            temp.set_color(move.color);
+            text += " and chooses ";
+            append_card(text, temp);
+        }
+    } else if (move.type == play_drawn) {
+        text += "plays the drawn card ";
+        append_card(text, engine.get_drawn_card());
+    } else if (move.type == keep_drawn) {
+        text += "keeps the drawn card";
+    } else {
+        text += "draws a card";
+    }
+    return text;
+}
+
+COLOR FromString(const string& str) {
+    if (str == "red")
+        return red;
+    else if (str == "green")
+        return green;
+    else if (str == "blue")
+        return blue;
+    else if (str == "yellow")
+        return yellow;
+    else
+        return wild;
+}
+
+// Function to print the outcome of a batch of headless games
+
+void print_result(const SimulationResult& result, int amount_players, double seconds) {
+    cout << "time: " << seconds << " s, " << result.games / seconds << " games/s" << endl;
+    cout << "average turns: " << (double) result.total_turns / result.games << endl;
+    for (int i = 0; i < amount_players; i++) {
+        cout << "PLAYER " << i + 1 << " wins: " << result.wins[i] << endl;
+    }
+    cout << "unfinished: " << result.unfinished << endl;
+}
+
+// Function to play games headless and report the throughput
+// usage: main --simulate [games] [seed] [players]
+//        main --tournament [games] [seed] [players] [threads] [pin]
+//        main --scaling [games] [seed] [players] [max threads]
+
+int simulate(int argc, char** argv) {
+    string mode = argv[1];
+    long long n_games = argc > 2 ? atoll(argv[2]) : 1000000;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    int amount_players = argc > 4 ? atoi(argv[4]) : 4;
+    int threads = argc > 5 ? atoi(argv[5]) : thread::hardware_concurrency();
+    bool pin = argc > 6 && atoi(argv[6]) != 0;
+    if (n_games <= 0 || amount_players < MIN_PLAYERS || amount_players > MAX_PLAYERS || threads < 1) {
+        cout << "invalid simulation arguments" << endl;
+        return 1;
+    }
+
+    if (mode == "--simulate") {
+        cout << n_games << " games, " << amount_players << " players, seed " << seed << endl;
+        auto start = chrono::steady_clock::now();
+        SimulationResult result = run_games(n_games, seed, amount_players);
+        print_result(result, amount_players, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        return 0;
+    }
+
+    if (mode == "--tournament") {
+        cout << n_games << " games, " << amount_players << " players, seed " << seed;
+        cout << ", " << threads << " threads" << (pin ? " (pinned)" : "") << endl;
+        WorkStealingPool pool(threads, pin);
+        auto start = chrono::steady_clock::now();
+        SimulationResult result = run_games_parallel(n_games, seed, amount_players, pool);
+        print_result(result, amount_players, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        return 0;
+    }
+
+    // scaling report: the same games on 1, 2, 4 ... threads
+    cout << "threads,seconds,games_per_s,speedup,efficiency,same_result" << endl;
+    SimulationResult reference;
+    double base_rate = 0;
+    for (int t = 1; t <= threads; t = (t * 2 > threads && t < threads) ? threads : t * 2) {
+        WorkStealingPool pool(t, true);
+        auto start = chrono::steady_clock::now();
+        SimulationResult result = run_games_parallel(n_games, seed, amount_players, pool);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double rate = result.games / seconds;
+        if (t == 1) {
+            reference = result;
+            base_rate = rate;
+        }
+        bool same = result.total_turns == reference.total_turns && result.unfinished == reference.unfinished;
+        for (int i = 0; i < amount_players; i++) {
+            same = same && result.wins[i] == reference.wins[i];
+        }
+        cout << t << "," << seconds << "," << rate << "," << rate / base_rate << ",";
+        cout << rate / base_rate / t << "," << (same ? "yes" : "no") << endl;
+    }
+    return 0;
+}
+
+// Function to gather GameStats over many games on all threads and print the summary. The game lengths are
+// also counted exactly, one pass on one thread, to show how far off the sketch's quantiles are.
+// usage: main --stats [games] [seed] [players] [threads]
+
+int stats(int argc, char** argv) {
+    long long n_games = argc > 2 ? atoll(argv[2]) : 1000000;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    int amount_players = argc > 4 ? atoi(argv[4]) : 4;
+    int threads = argc > 5 ? atoi(argv[5]) : thread::hardware_concurrency();
+    if (n_games <= 0 || amount_players < MIN_PLAYERS || amount_players > MAX_PLAYERS || threads < 1) {
+        cout << "invalid stats arguments" << endl;
+        return 1;
+    }
+
+    cout << n_games << " games, " << amount_players << " players, seed " << seed << ", " << threads << " threads" << endl;
+    WorkStealingPool pool(threads);
+    auto start = chrono::steady_clock::now();
+    GameStats result = collect_stats(n_games, seed, amount_players, pool);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "time: " << seconds << " s, " << n_games / seconds << " games/s, unfinished: " << result.unfinished << endl;
+
+    cout << "seat,starts,wins,win_rate,wins_from_start,win_rate_from_start" << endl;
+    for (int i = 0; i < amount_players; i++) {
+        cout << i << "," << result.starts[i] << "," << result.wins[i] << "," << (double) result.wins[i] / result.games << ",";
+        cout << result.wins_after_start[i] << "," << (double) result.wins_after_start[i] / result.games << endl;
+    }
+
+    const char* names[GAME_STATS] = {"turns", "cards_drawn", "reshuffles", "cards_left"};
+    cout << "stat,mean,stddev,p50,p90,p99,max,values_held" << endl;
+    for (int s = 0; s < GAME_STATS; s++) {
+        const KllSketch& sketch = result.sketches[s];
+        cout << names[s] << "," << result.mean(static_cast<GAME_STAT> (s)) << "," << result.stddev(static_cast<GAME_STAT> (s)) << ",";
+        cout << sketch.quantile(0.5) << "," << sketch.quantile(0.9) << "," << sketch.quantile(0.99) << ",";
+        cout << result.highest[s] << "," << sketch.retained() << endl;
+    }
+
+    cout << "cards_left_in_hand,losing_hands" << endl;
+    for (int i = 0; i <= MAX_DECKS * DECK_SIZE; i++) {
+        if (result.cards_left[i] != 0) {
+            cout << i << "," << result.cards_left[i] << endl;
+        }
+    }
+
+    // the exact ranks around each sketch answer, with ties an answer is right anywhere in [below, at]
+    long long lengths[MAX_TURNS + 1] = {};
+    GameEngine engine;
+    for (long long g = 0; g < n_games; g++) {
+        engine.new_game(amount_players, game_seed(seed, g));
+        while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+            engine.step(simple_policy(engine));
+        }
+        lengths[engine.get_turn_count()]++;
+    }
+    cout << "turns_quantile,sketch,rank_error" << endl;
+    double worst = 0;
+    for (double q : {0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999}) {
+        int answer = (int) result.sketches[stat_turns].quantile(q);
+        long long below = 0;
+        for (int t = 0; t < answer; t++) {
+            below += lengths[t];
+        }
+        double low = (double) below / n_games, high = (double) (below + lengths[answer]) / n_games;
+        double error = q < low ? low - q : q > high ? q - high : 0;
+        worst = max(worst, error);
+        cout << q << "," << answer << "," << error << endl;
+    }
+    cout << "worst rank error " << worst << (worst < 2.0 / KLL_K ? " OK" : " HIGH") << endl;
+    return 0;
+}
+
+// Function to play games on all threads with every event going through an EventBus to a tally, a text log and a
+// raw recording, each drained on a consumer thread of its own, and to compare with the same games unobserved
+// usage: main --events [games] [seed] [players] [threads] [log file] [record file]
+
+int events(int argc, char** argv) {
+    long long n_games = argc > 2 ? atoll(argv[2]) : 200000;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    int amount_players = argc > 4 ? atoi(argv[4]) : 4;
+    int threads = argc > 5 ? atoi(argv[5]) : thread::hardware_concurrency();
+    string log_path = argc > 6 ? argv[6] : "/dev/null";
+    string record_path = argc > 7 ? argv[7] : "/dev/null";
+    if (n_games <= 0 || amount_players < MIN_PLAYERS || amount_players > MAX_PLAYERS || threads < 1) {
+        cout << "invalid events arguments" << endl;
+        return 1;
+    }
+    ofstream log_file(log_path);
+    ofstream record_file(record_path, ios::binary);
+    if (!log_file || !record_file) {
+        cout << "cannot open the log or record file" << endl;
+        return 1;
+    }
+
+    cout << n_games << " games, " << amount_players << " players, seed " << seed << ", " << threads << " threads" << endl;
+    WorkStealingPool pool(threads);
+    auto start = chrono::steady_clock::now();
+    SimulationResult reference = run_games_parallel(n_games, seed, amount_players, pool);
+    double base_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    EventTally tally;
+    EventLog logger(log_file);
+    EventRecorder recorder(record_file);
+    EventObserver* observers[] = {&tally, &logger, &recorder};
+    EventBus bus(threads, observers, 3);
+    start = chrono::steady_clock::now();
+    bus.start();
+    SimulationResult result = run_games_on_bus(n_games, seed, amount_players, pool, bus);
+    double play_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    bus.stop();
+    double drain_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    long long n_events = 0;
+    for (int type = event_game_started; type <= event_game_won; type++) {
+        n_events += tally.by_type[type];
+    }
+    cout << "observers,seconds,games_per_s,events,events_per_s,dropped" << endl;
+    cout << "none," << base_seconds << "," << n_games / base_seconds << ",0,0,0" << endl;
+    cout << "tally+log+record," << play_seconds << "," << n_games / play_seconds << "," << n_events << ",";
+    cout << n_events / drain_seconds << "," << bus.dropped() << endl;
+    cout << "consumers done " << drain_seconds - play_seconds << " s after the last game" << endl;
+
+    // with nothing dropped the event stream alone must give the same outcome as the games
+    bool same = result.total_turns == reference.total_turns && result.unfinished == reference.unfinished;
+    bool agree = tally.by_type[event_game_started] == n_games && tally.by_type[event_game_won] == n_games - result.unfinished;
+    for (int i = 0; i < amount_players; i++) {
+        same = same && result.wins[i] == reference.wins[i];
+        agree = agree && tally.wins[i] == result.wins[i];
+    }
+    cout << "same_result " << (same ? "yes" : "no") << ", tally_matches " << (agree ? "yes" : (bus.dropped() > 0 ? "no (events dropped)" : "no")) << endl;
+    return same && (agree || bus.dropped() > 0) ? 0 : 1;
+}
+
+// Function to play the same games under house-rule variants, each one its own engine instantiation
+// usage: main --variants [games] [seed] [players] [rules]
+// rules is "all" (default) or a rule set like stacking+jump-in, see rules.h
+
+int variants(int argc, char** argv) {
+    long long n_games = argc > 2 ? atoll(argv[2]) : 100000;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    int amount_players = argc > 4 ? atoi(argv[4]) : 4;
+    string rules = argc > 5 ? argv[5] : "all";
+    int only = rules == "all" ? -1 : parse_rules(rules);
+    if (n_games <= 0 || amount_players < MIN_PLAYERS || amount_players > MAX_PLAYERS || (rules != "all" && only < 0)) {
+        cout << "invalid variants arguments" << endl;
+        return 1;
+    }
+
+    cout << n_games << " games, " << amount_players << " players, seed " << seed << endl;
+    cout << "rules,seconds,games_per_s,average_turns,unfinished" << endl;
+    for (int flags = 0; flags < RULE_VARIANTS; flags++) {
+        if (only >= 0 && flags != only) {
+            continue;
+        }
+        auto start = chrono::steady_clock::now();
+        SimulationResult result = dispatch_rules(flags, [&](auto rule_set) {
+            return run_games<decltype(rule_set)>(n_games, seed, amount_players);
+        });
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << rules_name(flags) << "," << seconds << "," << n_games / seconds << ",";
+        cout << (double) result.total_turns / result.games << "," << result.unfinished << endl;
+    }
+    return 0;
+}
+
+// Function to count the cards seat has not seen from scratch: the whole deck minus its hand and the discard pile
+
+void count_unseen(const GameEngine& engine, int seat, int counts[CARD_CODES]) {
+    for (int code = 0; code < CARD_CODES; code++) {
+        counts[code] = -engine.get_player(seat).count(player::from_code(code));
+    }
+    for (int i = 0; i < DECK_SIZE; i++) {
+        counts[MASTER_DECK[i].get_code()]++;
+    }
+    const CardPiles& piles = engine.get_piles();
+    for (int pos = 0; pos < piles.get_discard_size(); pos++) {
+        counts[piles.discard_at(pos).get_code()]--;
+    }
+}
+
+// Function to answer CardTracker's questions from counts made by count_unseen, card by card
+
+void scratch_chances(const int counts[CARD_CODES], card top, int opponent_size, double& draw_playable, double held[5]) {
+    int total = 0, fits = 0, colors[5] = {};
+    for (int code = 0; code < CARD_CODES; code++) {
+        total += counts[code];
+        fits += top == player::from_code(code) ? counts[code] : 0;
+        colors[code >> 4] += counts[code];
+    }
+    draw_playable = total > 0 ? (double) fits / total : 0;
+    for (int col = red; col <= yellow; col++) {
+        double none = 1;
+        for (int i = 0; i < opponent_size; i++) {
+            none *= total - i > 0 ? (double) (total - colors[col] - i) / (total - i) : 0;
+        }
+        held[col] = opponent_size > 0 ? 1 - (none > 0 ? none : 0) : 0;
+    }
+}
+
+// Function to check the incremental CardTracker against counting from scratch, compare its chances with what
+// the games did, and time both ways of asking on every turn
+// usage: main --tracker [games] [seed] [players]
+
+int tracker(int argc, char** argv) {
+    long long n_games = argc > 2 ? atoll(argv[2]) : 20000;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    int amount_players = argc > 4 ? atoi(argv[4]) : 4;
+    if (n_games <= 0 || amount_players < MIN_PLAYERS || amount_players > MAX_PLAYERS) {
+        cout << "invalid tracker arguments" << endl;
+        return 1;
+    }
+    cout << n_games << " games, " << amount_players << " players, seed " << seed << endl;
+
+    // every seat asks on its own turn: the chance its next draw fits, and the chance the next seat holds each colour
+    GameEngine engine;
+    CardTracker trackers[MAX_PLAYERS];
+    int counts[CARD_CODES];
+    long long turns = 0, mismatches = 0, draws = 0, draw_fits = 0, color_held = 0;
+    double draw_predicted = 0, color_predicted = 0;
+    for (long long g = 0; g < n_games; g++) {
+        engine.new_game(amount_players, game_seed(seed, g));
+        for (int i = 0; i < amount_players; i++) {
+            trackers[i].start(amount_players, i);
+        }
+        while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+            int seat = engine.get_turn();
+            int next = engine.get_seating().peek_next();
+            CardTracker& seen = trackers[seat];
+            seen.follow(engine);
+            count_unseen(engine, seat, counts);
+            double draw_playable, held[5];
+            scratch_chances(counts, engine.get_played_card(), engine.get_player(next).get_size(), draw_playable, held);
+            bool same = fabs(seen.p_draw_playable(engine.get_played_card()) - draw_playable) < 1e-9;
+            for (int code = 0; code < CARD_CODES; code++) {
+                same = same && counts[code] == seen.unseen_code(player::from_code(code));
+            }
+            for (int col = red; col <= yellow; col++) {
+                double p = seen.p_holds_color(next, static_cast<COLOR> (col));
+                same = same && fabs(p - held[col]) < 1e-9;
+                color_predicted += p;
+                color_held += engine.get_player(next).color_count(static_cast<COLOR> (col)) > 0;
+            }
+            mismatches += !same;
+            turns++;
+
+            Move move = simple_policy(engine);
+            card top = engine.get_played_card();
+            bool drawing = move.type == draw_card && !engine.is_drawn_pending();
+            engine.step(move);
+            if (drawing) {
+                draws++;
+                draw_predicted += draw_playable;
+                draw_fits += engine.get_drawn_card() == top;
+            }
+        }
+    }
+    cout << "turns,mismatches,draws,draw_fits_predicted,draw_fits_seen,color_held_predicted,color_held_seen" << endl;
+    cout << turns << "," << mismatches << "," << draws << "," << draw_predicted / draws << "," << (double) draw_fits / draws << ",";
+    cout << color_predicted / (4 * turns) << "," << (double) color_held / (4 * turns) << endl;
+
+    // the same questions asked on every turn, answered by the tracker and from scratch
+    cout << "analysis,seconds,games_per_s,ns_per_turn" << endl;
+    const char* names[3] = {"none", "tracker", "scratch"};
+    double base_seconds = 0;
+    for (int way = 0; way < 3; way++) {
+        CardTracker timed[MAX_PLAYERS];
+        volatile double sink = 0;
+        long long timed_turns = 0;
+        auto start = chrono::steady_clock::now();
+        for (long long g = 0; g < n_games; g++) {
+            engine.new_game(amount_players, game_seed(seed, g));
+            for (int i = 0; i < amount_players; i++) {
+                timed[i].start(amount_players, i);
+            }
+            while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+                int seat = engine.get_turn();
+                int next = engine.get_seating().peek_next();
+                if (way == 1) {
+                    timed[seat].follow(engine);
+                    sink += timed[seat].p_draw_playable();
+                    for (int col = red; col <= yellow; col++) {
+                        sink += timed[seat].p_holds_color(next, static_cast<COLOR> (col));
+                    }
+                } else if (way == 2) {
+                    double draw_playable, held[5];
+                    count_unseen(engine, seat, counts);
+                    scratch_chances(counts, engine.get_played_card(), engine.get_player(next).get_size(), draw_playable, held);
+                    sink += draw_playable + held[red] + held[green] + held[blue] + held[yellow];
+                }
+                engine.step(simple_policy(engine));
+                timed_turns++;
+            }
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        base_seconds = way == 0 ? seconds : base_seconds;
+        cout << names[way] << "," << seconds << "," << n_games / seconds << ",";
+        cout << (way == 0 ? 0 : (seconds - base_seconds) * 1e9 / timed_turns) << endl;
+    }
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Function to compare the lockstep BatchSimulator at every SIMD level against the scalar engine
+// usage: main --batch [games] [seed] [players] [lanes]
+
+int batch(int argc, char** argv) {
+    long long n_games = argc > 2 ? atoll(argv[2]) : 200000;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    int amount_players = argc > 4 ? atoi(argv[4]) : 4;
+    int lanes = argc > 5 ? atoi(argv[5]) : BATCH_LANES;
+    if (n_games <= 0 || amount_players < MIN_PLAYERS || amount_players > MAX_PLAYERS || lanes < 1) {
+        cout << "invalid batch arguments" << endl;
+        return 1;
+    }
+
+    cout << n_games << " games, " << amount_players << " players, seed " << seed << ", " << lanes << " lanes" << endl;
+    cout << "simulator,seconds,games_per_s,speedup,same_result" << endl;
+    auto start = chrono::steady_clock::now();
+    SimulationResult reference = run_games(n_games, seed, amount_players);
+    double base_rate = n_games / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "engine," << n_games / base_rate << "," << base_rate << ",1,yes" << endl;
+
+    bool all_same = true;
+    for (int level = simd_scalar; level <= detect_simd(); level++) {
+        BatchSimulator simulator(lanes, static_cast<SIMD_LEVEL> (level));
+        SimulationResult result;
+        start = chrono::steady_clock::now();
+        simulator.run(0, n_games, seed, amount_players, result);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        bool same = result.games == reference.games && result.total_turns == reference.total_turns && result.unfinished == reference.unfinished;
+        for (int i = 0; i < amount_players; i++) {
+            same = same && result.wins[i] == reference.wins[i];
+        }
+        all_same = all_same && same;
+        cout << "batch-" << simd_name(simulator.get_level()) << "," << seconds << "," << n_games / seconds << ",";
+        cout << n_games / seconds / base_rate << "," << (same ? "yes" : "no") << endl;
+    }
+    return all_same ? 0 : 1;
+}
+
+// Function to run a tournament with the game loop instrumented and export what was recorded
+// usage: main --instrument [games] [seed] [players] [threads] [summary.json] [trace.json]
+
+int instrument(int argc, char** argv) {
+#ifdef UNO_INSTRUMENT
+    long long n_games = argc > 2 ? atoll(argv[2]) : 100000;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    int amount_players = argc > 4 ? atoi(argv[4]) : 4;
+    int threads = argc > 5 ? atoi(argv[5]) : thread::hardware_concurrency();
+    string summary_path = argc > 6 ? argv[6] : "instrument_summary.json";
+    string trace_path = argc > 7 ? argv[7] : "instrument_trace.json";
+    if (n_games <= 0 || amount_players < MIN_PLAYERS || amount_players > MAX_PLAYERS || threads < 1) {
+        cout << "invalid instrument arguments" << endl;
+        return 1;
+    }
+
+    WorkStealingPool pool(threads);
+    Instrumentation::reset();
+    auto start = chrono::steady_clock::now();
+    SimulationResult result = run_games_parallel(n_games, seed, amount_players, pool);
+    print_result(result, amount_players, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+
+    ofstream summary(summary_path);
+    Instrumentation::write_summary(summary);
+    ofstream trace(trace_path);
+    Instrumentation::write_trace(trace);
+    Instrumentation::write_summary(cout);
+    cout << "summary written to " << summary_path << ", trace to " << trace_path << endl;
+    return 0;
+#else
+    (void) argc;
+    (void) argv;
+    cout << "instrumentation is compiled out, rebuild with make INSTRUMENT=1" << endl;
+    return 1;
+#endif
+}
+
+// Function to verify that headless games in steady state never call the global allocator
+// usage: main --check-alloc [games] [players]
+
+int check_alloc(int argc, char** argv) {
+    long long n_games = argc > 2 ? atoll(argv[2]) : 10000;
+    int amount_players = argc > 3 ? atoi(argv[3]) : 4;
+    if (n_games <= 0 || amount_players < MIN_PLAYERS || amount_players > MAX_PLAYERS) {
+        cout << "invalid check arguments" << endl;
+        return 1;
+    }
+
+    GameEngine engine;
+    SimulationResult result;
+    // the first game warms up everything the engine keeps between games
+    play_game(engine, amount_players, game_seed(1, 0), result);
+
+    long long before = global_allocations;
+    for (long long i = 1; i <= n_games; i++) {
+        play_game(engine, amount_players, game_seed(1, i), result);
+    }
+    long long allocations = global_allocations - before;
+
+    cout << n_games << " games, " << allocations << " global allocations" << endl;
+    if (allocations != 0) {
+        cout << "FAILED: games allocate in steady state" << endl;
+        return 1;
+    }
+    cout << "OK" << endl;
+    return 0;
+}
+
+// Function to draw the turn screens of simple_policy games through every renderer into out, and, for
+// comparison, the way the game loop printed them before: a stream write and endl per line
+// usage: main --render-bench [games] [players] [file]
+
+void stream_frame(const GameEngine& engine, ostream& out) {
+    out << "PLAYER " << engine.get_turn() + 1 << endl;
+    out << "Cards remaining for each player " << endl;
+    out << "====================================" << endl;
+    for (int i = 0; i < engine.get_amount_players(); i++) {
+        out << "PLAYER " << i + 1 << ": " << engine.get_player(i).get_size() << "   ";
+    }
+    out << endl;
+    out << "Played Card: " << engine.get_played_card() << endl;
+    out << "PLAYER " << engine.get_turn() + 1 << endl;
+    out << "====================================" << endl;
+    card cards[DECK_SIZE];
+    int size = engine.get_player(engine.get_turn()).get_cards(cards);
+    for (int i = 0; i < size; i++) {
+        out << i + 1 << ":  " << cards[i] << endl;
+    }
+}
+
+int render_bench(int argc, char** argv) {
+    long long n_games = argc > 2 ? atoll(argv[2]) : 2000;
+    int amount_players = argc > 3 ? atoi(argv[3]) : 4;
+    string path = argc > 4 ? argv[4] : "/dev/null";
+    if (n_games <= 0 || amount_players < MIN_PLAYERS || amount_players > MAX_PLAYERS) {
+        cout << "invalid render arguments" << endl;
+        return 1;
+    }
+    ofstream out(path);
+    if (!out) {
+        cout << "cannot write " << path << endl;
+        return 1;
+    }
+
+    cout << n_games << " games, " << amount_players << " players, frames written to " << path << endl;
+    cout << "renderer,frames,seconds,frames_per_s" << endl;
+    AnsiRenderer ansi_renderer(out);
+    PlainRenderer plain_renderer(out);
+    NullRenderer null_renderer;
+    Renderer* renderers[4] = {&ansi_renderer, &plain_renderer, &null_renderer, &null_renderer};
+    const char* names[4] = {"ansi", "plain", "null", "stream"};
+    for (int mode = 0; mode < 4; mode++) {
+        Renderer* renderer = renderers[mode];
+        GameEngine engine;
+        long long frames = 0;
+        auto start = chrono::steady_clock::now();
+        for (long long game = 0; game < n_games; game++) {
+            engine.new_game(amount_players, game_seed(1, game));
+            while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+                if (!engine.is_drawn_pending()) {
+                    if (mode == 3) {
+                        stream_frame(engine, out);
+                    } else {
+                        renderer->table(engine);
+                    }
+                    frames++;
+                }
+                engine.step(simple_policy(engine));
+            }
+        }
+        renderer->flush();
+        out.flush();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << names[mode] << "," << frames << "," << seconds << "," << frames / seconds << endl;
+    }
+    return 0;
+}
+
+// Function to write games to a record file, or to replay a record file and check every game
+// usage: main --record <file> [games] [seed] [players]
+//        main --replay <file> [first game] [games]
+
+int record(int argc, char** argv) {
+    if (argc < 3) {
+        cout << "missing record file" << endl;
+        return 1;
+    }
+    GameEngine engine;
+    vector<Move> moves;
+    auto start = chrono::steady_clock::now();
+
+    if (string(argv[1]) == "--record") {
+        long long n_games = argc > 3 ? atoll(argv[3]) : 1000000;
+        uint64_t seed = argc > 4 ? strtoull(argv[4], NULL, 10) : 1;
+        int amount_players = argc > 5 ? atoi(argv[5]) : 4;
+        if (n_games <= 0 || amount_players < MIN_PLAYERS || amount_players > MAX_PLAYERS) {
+            cout << "invalid record arguments" << endl;
+            return 1;
+        }
+        GameRecordWriter writer;
+        if (!writer.open(argv[2])) {
+            cout << "cannot create " << argv[2] << endl;
+            return 1;
+        }
+        for (long long i = 0; i < n_games; i++) {
+            record_game(engine, amount_players, game_seed(seed, i), writer, moves);
+        }
+        if (!writer.close()) {
+            cout << "write to " << argv[2] << " failed" << endl;
+            return 1;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << n_games << " games recorded in " << seconds << " s, " << n_games / seconds << " games/s" << endl;
+        return 0;
+    }
+
+    GameRecordReader reader;
+    if (!reader.open(argv[2])) {
+        cout << "cannot read " << argv[2] << endl;
+        return 1;
+    }
+    long long first = argc > 3 ? atoll(argv[3]) : 0;
+    long long n_games = argc > 4 ? atoll(argv[4]) : reader.get_game_count() - first;
+    GameRecordView view;
+    long long replayed = 0;
+    long long mismatches = 0;
+    bool ok = reader.get_game(first, view);
+    while (ok && replayed < n_games) {
+        if (!replay_game(view, engine, moves)) {
+            mismatches++;
+        }
+        replayed++;
+        ok = reader.next(view);
+    }
+    if (!ok && replayed < n_games && !reader.at_end()) {
+        cout << "game " << first + replayed << " of " << argv[2] << " is damaged" << endl;
+        return 1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << replayed << " of " << reader.get_game_count() << " games replayed in " << seconds << " s, ";
+    cout << replayed / seconds << " games/s, " << mismatches << " mismatches" << endl;
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Function to pit one MctsBot (seat 1) against simple_policy and report search speed and latency
+// usage: main --mcts [games] [iterations] [threads] [players]
+
+int mcts_bench(int argc, char** argv) {
+    long long n_games = argc > 2 ? atoll(argv[2]) : 20;
+    MctsConfig config;
+    config.iterations = argc > 3 ? atoi(argv[3]) : 2000;
+    config.threads = argc > 4 ? atoi(argv[4]) : thread::hardware_concurrency();
+    int amount_players = argc > 5 ? atoi(argv[5]) : 4;
+    if (n_games <= 0 || config.iterations <= 0 || config.threads < 1 || amount_players < MIN_PLAYERS || amount_players > MAX_PLAYERS) {
+        cout << "invalid mcts arguments" << endl;
+        return 1;
+    }
+
+    MctsBot bot(config, 1);
+    GameEngine engine;
+    vector<double> latencies;
+    long long playouts = 0;
+    double search_seconds = 0;
+    long long bot_wins = 0;
+    for (long long g = 0; g < n_games; g++) {
+        engine.new_game(amount_players, game_seed(2, g));
+        while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+            if (engine.get_turn() != 0) {
+                engine.step(simple_policy(engine));
+                continue;
+            }
+            auto start = chrono::steady_clock::now();
+            Move move = bot.choose(engine);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (bot.get_playouts() > 0) {
+                latencies.push_back(seconds * 1000);
+                playouts += bot.get_playouts();
+                search_seconds += seconds;
+            }
+            engine.step(move);
+        }
+        if (engine.get_winner() == 0) {
+            bot_wins++;
+        }
+    }
+
+    sort(latencies.begin(), latencies.end());
+    cout << n_games << " games, " << amount_players << " players, " << config.iterations << " playouts per decision, ";
+    cout << config.threads << " threads" << endl;
+    cout << "bot win rate: " << (double) bot_wins / n_games << " (even share " << 1.0 / amount_players << ")" << endl;
+    cout << "playouts/s: " << playouts / search_seconds << endl;
+    if (!latencies.empty()) {
+        cout << "decision latency ms: p50 " << latencies[latencies.size() / 2];
+        cout << ", p99 " << latencies[latencies.size() * 99 / 100] << ", searched decisions " << latencies.size() << endl;
+    }
+    return 0;
+}
+
+// Function to solve two-player endgames taken from simple_policy games and report search speed
+// usage: main --solve [positions] [cards] [ms] [threads] [tt_mb]
+
+int solve_bench(int argc, char** argv) {
+    long long n_positions = argc > 2 ? atoll(argv[2]) : 20;
+    int max_cards = argc > 3 ? atoi(argv[3]) : 6;
+    double time_ms = argc > 4 ? atof(argv[4]) : 200;
+    int threads = argc > 5 ? atoi(argv[5]) : 1;
+    int tt_mb = argc > 6 ? atoi(argv[6]) : 64;
+    if (n_positions <= 0 || max_cards < 2 || time_ms <= 0 || threads < 1 || tt_mb < 1) {
+        cout << "invalid solve arguments" << endl;
+        return 1;
+    }
+
+    EndgameSolver solver(tt_mb, threads);
+    GameEngine engine;
+    long long solved = 0, proven = 0, agree = 0, depth_sum = 0;
+    long long nodes = 0, probes = 0, hits = 0;
+    double value_sum = 0, seconds = 0;
+    for (long long g = 0; solved < n_positions; g++) {
+        // play on until both hands together hold at most max_cards cards
+        engine.new_game(2, game_seed(3, g));
+        while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS &&
+                (engine.is_drawn_pending() || engine.get_player(0).get_size() + engine.get_player(1).get_size() > max_cards)) {
+            engine.step(simple_policy(engine));
+        }
+        if (engine.is_over() || engine.get_turn_count() >= MAX_TURNS) {
+            continue;
+        }
+
+        EndgamePosition pos = EndgamePosition::from_engine(engine);
+        auto start = chrono::steady_clock::now();
+        SolveResult result = solver.solve(pos, SOLVER_MAX_DEPTH, time_ms);
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        solved++;
+        proven += result.proven;
+        depth_sum += result.depth;
+        value_sum += result.value;
+        nodes += result.nodes;
+        probes += result.tt_probes;
+        hits += result.tt_hits;
+        agree += EndgameSolver::key_of(engine, simple_policy(engine)) == result.move;
+    }
+
+    cout << solved << " positions of at most " << max_cards << " cards in hand, " << time_ms << " ms each, ";
+    cout << threads << " threads, " << tt_mb << " MB table" << endl;
+    cout << "nodes/s: " << nodes / seconds << " (" << nodes << " nodes in " << seconds << " s)" << endl;
+    cout << "table hit rate: " << (double) hits / probes << endl;
+    cout << "proven exact: " << proven << ", mean depth reached " << (double) depth_sum / solved;
+    cout << ", mean value for the player to move " << value_sum / solved << endl;
+    cout << "simple_policy picks the solver's move in " << (double) agree / solved << " of positions" << endl;
+    return 0;
+}
+
+// Function to run a Swiss tournament of bots of known skill through the PlayerRegistry: the pairing time of every
+// round, the games per second of the tables, how well the ratings found the skills, and a heads-up round robin
+// of a small field checked for every pair meeting exactly once
+// usage: main --rating [entrants] [rounds] [seats] [threads] [seed] [registry file]
+
+int rating(int argc, char** argv) {
+    uint32_t entrants = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+    int rounds = argc > 3 ? atoi(argv[3]) : 5;
+    int seats = argc > 4 ? atoi(argv[4]) : 4;
+    int threads = argc > 5 ? atoi(argv[5]) : thread::hardware_concurrency();
+    uint64_t seed = argc > 6 ? strtoull(argv[6], NULL, 10) : 1;
+    const char* path = argc > 7 ? argv[7] : NULL;
+    if (entrants < 2 || rounds < 1 || seats < MIN_PLAYERS || seats > MAX_PLAYERS || threads < 1) {
+        cout << "invalid rating arguments" << endl;
+        return 1;
+    }
+
+    PlayerRegistry registry;
+    Rng skills(seed);
+    for (uint32_t id = 0; id < entrants; id++) {
+        registry.add(skills.bounded(1 << 24) / (float) (1 << 24));
+    }
+    cout << entrants << " entrants, " << rounds << " Swiss rounds at tables of " << seats << ", " << threads << " threads" << endl;
+
+    WorkStealingPool pool(threads);
+    Tournament tournament(registry, pool, seed);
+    Round round;
+    double pairing = 0, slowest = 0, playing = 0;
+    for (int r = 0; r < rounds; r++) {
+        auto start = chrono::steady_clock::now();
+        pair_swiss(registry, seats, round);
+        double paired = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        tournament.play_round(round);
+        double played = chrono::duration<double>(chrono::steady_clock::now() - start).count() - paired;
+        cout << "round " << r + 1 << ": " << round.tables() << " tables, " << round.byes.size() << " byes, pairing " << paired * 1000 << " ms, playing " << played << " s" << endl;
+        pairing += paired;
+        slowest = max(slowest, paired);
+        playing += played;
+    }
+    cout << "pairing: " << pairing / rounds * 1000 << " ms per round, slowest " << slowest * 1000 << " ms" << endl;
+    cout << "games: " << tournament.get_games_played() << ", " << tournament.get_games_played() / playing << " games/s" << endl;
+
+    // Pearson correlation of each rating with the hidden skill
+    double ratings[2] = {0, 0}, products[2] = {0, 0}, squares[2] = {0, 0}, skill_sum = 0, skill_squares = 0;
+    for (uint32_t id = 0; id < entrants; id++) {
+        double values[2] = {registry.rating[id], registry.elo[id]};
+        skill_sum += registry.skill[id];
+        skill_squares += registry.skill[id] * registry.skill[id];
+        for (int k = 0; k < 2; k++) {
+            ratings[k] += values[k];
+            products[k] += values[k] * registry.skill[id];
+            squares[k] += values[k] * values[k];
+        }
+    }
+    const char* names[2] = {"glicko", "elo"};
+    for (int k = 0; k < 2; k++) {
+        double covariance = products[k] / entrants - ratings[k] / entrants * skill_sum / entrants;
+        double spread = squares[k] / entrants - ratings[k] * ratings[k] / entrants / entrants;
+        double skill_spread = skill_squares / entrants - skill_sum * skill_sum / entrants / entrants;
+        cout << names[k] << " correlation with skill: " << covariance / sqrt(spread * skill_spread) << endl;
+    }
+
+    uint32_t best[5];
+    int shown = min<uint32_t>(5, entrants);
+    for (int i = 0; i < shown; i++) {
+        best[i] = entrants;
+        for (uint32_t id = 0; id < entrants; id++) {
+            bool taken = false;
+            for (int k = 0; k < i; k++) {
+                taken = taken || best[k] == id;
+            }
+            if (!taken && (best[i] == entrants || registry.rating[id] > registry.rating[best[i]])) {
+                best[i] = id;
+            }
+        }
+    }
+    cout << "id,skill,score,glicko,deviation,elo" << endl;
+    for (int i = 0; i < shown; i++) {
+        uint32_t id = best[i];
+        cout << id << "," << registry.skill[id] << "," << registry.score[id] << "," << registry.rating[id] << ",";
+        cout << registry.deviation[id] << "," << registry.elo[id] << endl;
+    }
+
+    if (path != NULL) {
+        PlayerRegistry loaded;
+        bool same = registry.save(path) && loaded.load(path) && loaded.size() == registry.size();
+        for (uint32_t id = 0; same && id < entrants; id++) {
+            same = loaded.rating[id] == registry.rating[id] && loaded.deviation[id] == registry.deviation[id] && loaded.elo[id] == registry.elo[id];
+            same = same && loaded.games[id] == registry.games[id] && loaded.wins[id] == registry.wins[id] && loaded.skill[id] == registry.skill[id];
+        }
+        cout << "registry saved to " << path << " and loaded back: " << (same ? "same" : "DIFFERENT") << endl;
+    }
+
+    // a heads-up round robin of a small field, every pair must meet exactly once
+    uint32_t field = 33;
+    PlayerRegistry small;
+    for (uint32_t id = 0; id < field; id++) {
+        small.add(id / (float) field);
+    }
+    Tournament robin(small, pool, seed);
+    uint8_t met[33][33] = {};
+    uint32_t robin_rounds = field + (field & 1) - 1;
+    for (uint32_t r = 0; r < robin_rounds; r++) {
+        pair_round_robin(field, r, round);
+        for (int t = 0; t < round.tables(); t++) {
+            met[round.players[round.starts[t]]][round.players[round.starts[t] + 1]]++;
+            met[round.players[round.starts[t] + 1]][round.players[round.starts[t]]]++;
+        }
+        robin.play_round(round);
+    }
+    bool once = true;
+    for (uint32_t a = 0; a < field; a++) {
+        for (uint32_t b = 0; b < field; b++) {
+            once = once && met[a][b] == (a != b ? 1 : 0);
+        }
+    }
+    cout << "round robin of " << field << ": " << robin_rounds << " rounds, every pair met once: " << (once ? "yes" : "NO") << endl;
+    return 0;
+}
+
+// Function to play simple_policy games at tables of 2 to 64 players with 1, 2, 4 and 8 decks shuffled together,
+// to compare how often the discard pile has to go back into the main deck, and to check that dealing and
+// reshuffling with any number of decks never calls the global allocator
+// usage: main --decks [games] [seed]
+
+int decks(int argc, char** argv) {
+    long long n_games = argc > 2 ? atoll(argv[2]) : 1000;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    if (n_games <= 0) {
+        cout << "invalid decks arguments" << endl;
+        return 1;
+    }
+
+    const int tables[] = {2, 4, 5, 8, 16, 32, 64};
+    long long total_allocations = 0;
+    cout << "decks,players,hand,games_per_s,turns,reshuffles_per_game,turns_per_reshuffle,unfinished,allocations" << endl;
+    for (int n_decks = 1; n_decks <= MAX_DECKS; n_decks *= 2) {
+        for (int amount_players : tables) {
+            total_allocations += dispatch_decks(n_decks, [&](auto rules) {
+                typedef decltype(rules) Rules;
+                BasicEngine<Rules> engine;
+                long long turns = 0, reshuffles = 0, unfinished = 0;
+                long long before = global_allocations;
+                auto start = chrono::steady_clock::now();
+                for (long long g = 0; g < n_games; g++) {
+                    engine.new_game(amount_players, game_seed(seed, g));
+                    while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+                        engine.step(simple_policy(engine));
+                    }
+                    turns += engine.get_turn_count();
+                    reshuffles += engine.get_reshuffles();
+                    unfinished += engine.is_over() ? 0 : 1;
+                }
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                long long allocations = global_allocations - before;
+                cout << n_decks << "," << amount_players << "," << BasicEngine<Rules>::starting_hand(amount_players) << ",";
+                cout << n_games / seconds << "," << (double) turns / n_games << "," << (double) reshuffles / n_games << ",";
+                cout << (reshuffles > 0 ? (double) turns / reshuffles : 0) << "," << unfinished << "," << allocations << endl;
+                return allocations;
+            });
+        }
+    }
+    if (total_allocations != 0) {
+        cout << "FAILED: " << total_allocations << " global allocations while dealing and playing" << endl;
+        return 1;
+    }
+    cout << "OK" << endl;
+    return 0;
+}
+
+// Function to tune the weights of the HeuristicBot by self-play, one SPSA generation after another, checkpointing
+// after each, and to measure the default and the tuned weights against simple_policy on deals never tuned on
+// usage: main --tune [generations] [games per generation] [players] [threads] [seed] [checkpoint file]
+
+int tune(int argc, char** argv) {
+    int generations = argc > 2 ? atoi(argv[2]) : 20;
+    TunerConfig config;
+    config.games = argc > 3 ? atoll(argv[3]) : 200000;
+    config.amount_players = argc > 4 ? atoi(argv[4]) : 4;
+    int threads = argc > 5 ? atoi(argv[5]) : thread::hardware_concurrency();
+    config.seed = argc > 6 ? strtoull(argv[6], NULL, 10) : 1;
+    string checkpoint = argc > 7 ? argv[7] : "";
+    if (generations < 0 || config.games <= 0 || config.amount_players < MIN_PLAYERS || config.amount_players > MAX_PLAYERS || threads < 1) {
+        cout << "invalid tune arguments" << endl;
+        return 1;
+    }
+
+    WorkStealingPool pool(threads);
+    BotTuner tuner(config, pool);
+    if (!checkpoint.empty() && tuner.load(checkpoint)) {
+        cout << "resumed from " << checkpoint << " at generation " << tuner.get_generation() << endl;
+    } else if (!checkpoint.empty() && ifstream(checkpoint)) {
+        // never overwrite the progress of another run
+        cout << "checkpoint " << checkpoint << " is damaged or was written with other settings" << endl;
+        return 1;
+    }
+    cout << config.games << " deals per generation, " << config.amount_players << " players, " << threads << " threads" << endl;
+    cout << "generation,games,seconds,games_per_s,win_plus,win_minus" << endl;
+    for (int g = 0; g < generations; g++) {
+        TunerGeneration result = tuner.run_generation();
+        cout << result.generation << "," << result.games << "," << result.seconds << "," << result.games / result.seconds << ",";
+        cout << result.win_plus << "," << result.win_minus << endl;
+        if (!checkpoint.empty() && !tuner.save(checkpoint)) {
+            cout << "cannot write checkpoint " << checkpoint << endl;
+            return 1;
+        }
+    }
+
+    HeuristicWeights start;
+    const HeuristicWeights& tuned = tuner.get_weights();
+    cout << "feature,default,tuned" << endl;
+    for (int i = 0; i < HEURISTIC_FEATURES; i++) {
+        cout << feature_name(i) << "," << start.w[i] << "," << tuned.w[i] << endl;
+    }
+    // fresh deals, the seed of no generation
+    uint64_t held_out = game_seed(config.seed ^ 0xe7a1ULL, 0);
+    long long default_wins = bot_wins(HeuristicBot(start), config.games, config.amount_players, held_out, pool);
+    long long tuned_wins = bot_wins(HeuristicBot(tuned), config.games, config.amount_players, held_out, pool);
+    cout << "win rate against simple_policy, fair share " << 1.0 / config.amount_players << ": default ";
+    cout << (double) default_wins / config.games << ", tuned " << (double) tuned_wins / config.games << endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "--tune") {
+        return tune(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--decks") {
+        return decks(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--rating") {
+        return rating(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--instrument") {
+        return instrument(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--render-bench") {
+        return render_bench(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--variants") {
+        return variants(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--events") {
+        return events(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--stats") {
+        return stats(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--tracker") {
+        return tracker(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        return batch(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--solve") {
+        return solve_bench(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--mcts") {
+        return mcts_bench(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--check-alloc") {
+        return check_alloc(argc, argv);
+    }
+    if (argc > 1 && (string(argv[1]) == "--record" || string(argv[1]) == "--replay")) {
+        return record(argc, argv);
+    }
+    if (argc > 1 && (string(argv[1]) == "--simulate" || string(argv[1]) == "--tournament" || string(argv[1]) == "--scaling")) {
+        return simulate(argc, argv);
+    }
+
+    // the frame is drawn in place on a terminal and written as plain lines into a pipe or file
+    RENDER_MODE mode = isatty(STDOUT_FILENO) ? render_ansi : render_plain;
+    if (argc > 2 && string(argv[1]) == "--render") {
+        mode = string(argv[2]) == "plain" ? render_plain : string(argv[2]) == "null" ? render_null : render_ansi;
+    }
+    AnsiRenderer ansi_renderer(cout);
+    PlainRenderer plain_renderer(cout);
+    NullRenderer null_renderer;
+    Renderer* renderer = &ansi_renderer;
+    if (mode == render_plain) {
+        renderer = &plain_renderer;
+    } else if (mode == render_null) {
+        renderer = &null_renderer;
+    }
+
+    // one snapshot per turn, they share every hand and card that did not change
+    std::vector<GameSnapshot> history;
+    int amount_players;
+    int flag = 0;
+    while (flag == 0) {
+        renderer->message("Please enter amount of players: ");
+        renderer->flush();
+        cin >> amount_players;
+        if (amount_players >= MIN_PLAYERS && amount_players <= MAX_HUMAN_PLAYERS) {
+            renderer->message(to_string(amount_players) + " players entering game .... ");
+            flag = 1;
+            break;
+        } else {
+            renderer->message("invalid amount of players");
+        }
+    }
+
+    // the last amount_bots seats are played by the computer
+    int amount_bots = -1;
+    while (amount_bots < 0 || amount_bots > amount_players) {
+        renderer->message("Please enter amount of computer players: ");
+        renderer->flush();
+        cin >> amount_bots;
+    }
+    MctsConfig bot_config;
+    bot_config.iterations = 20000;
+    bot_config.threads = thread::hardware_concurrency();
+    MctsBot bot(bot_config, time(NULL));
+
+    /* create the components of the game: shuffle, deal and flip the starting card */
+    GameEngine engine;
+    engine.new_game(amount_players, time(NULL));
+    player* play_array = engine.get_players();
+
+
+#if TEST == PRINT_ALL_PLAYERS
+    /*print out testing */
+    for (int i = 0; i < amount_players; i++) {
+        cout << "player: " << i + 1 << endl;
+        play_array[i].print();
+    }
+#endif
+    /* the engine randomized who starts first */
+    renderer->message("PLAYER " + to_string(engine.get_turn() + 1) + " is randomly selected to play first");
+    if (engine.get_turn() < amount_players - amount_bots) {
+        confirm_turn(*renderer, engine.get_turn() + 1);
+    }
+
+    /* keep playing until a player wins */
+    while (!engine.is_over()) {
+        if (engine.get_turn() >= amount_players - amount_bots) {
+            Move move = bot.choose(engine);
+            renderer->message(describe_move(engine, move));
+            engine.step(move);
+            if (engine.is_over()) {
+                renderer->message("PLAYER " + to_string(engine.get_winner() + 1) + " has won the game.");
+                break;
+            }
+            if (!engine.is_drawn_pending() && engine.get_turn() < amount_players - amount_bots) {
+                confirm_turn(*renderer, engine.get_turn() + 1);
+            }
+            continue;
+        }
+
+        history.push_back(engine.snapshot());
+        int turn = engine.get_turn();
+        player* curr_player = &play_array[turn];
+        card played_card = engine.get_played_card();
+        {
+        INSTR_PHASE(phase_render);
+        renderer->table(engine);
+
+
+#if TEST == TEMP_DECK
+        renderer->flush();
+        engine.get_piles().print_discard();
+#endif
+        }
+        int check_flag = 0;
+        bool undo = false;
+        int index;
+        int size = curr_player->get_size();
+        // ask for which card to play into middle
+        while (check_flag == 0) {
+            renderer->message("which card do you want to play? ");
+            renderer->message("If you want to draw a card please enter '-1' ");
+            renderer->message("If you want to undo your last turn please enter '-2' ");
+            renderer->flush();
+
+            cin >> index;
+            //check if index is to go back to the start of the previous human turn
+            if (index == -2) {
+                if (history.size() < 2) {
+                    renderer->message("nothing to undo ");
+                    continue;
+                }
+                history.pop_back();
+                engine.restore(history.back());
+                history.pop_back();
+                undo = true;
+                check_flag = 1;
+            }//check if index is to draw a card
+            else if (index == -1) {
+                engine.step(Move(draw_card));
+                if (engine.is_drawn_pending()) {
+                    renderer->message(drawn_text(engine.get_drawn_card()));
+
+                    int play_draw_flag = 0;
+                    while (play_draw_flag == 0) {
+
+                        string temp_play;
+                        renderer->message("Do you want to play the drawn card [y/n] : ");
+                        renderer->flush();
+                        cin >> temp_play;
+                        if (temp_play == "y") {
+                            engine.step(Move(play_drawn));
+                            play_draw_flag = 1;
+                        }
+                        if (temp_play == "n") {
+                            engine.step(Move(keep_drawn));
+                            play_draw_flag = 1;
+                        }
+
+
+                    }
+
+                } else if (curr_player->get_size() > size) {
+                    renderer->message(drawn_text(engine.get_drawn_card()));
+                }
+                check_flag = 1;
+
+            }//check if index is valid
+            else if (index >= 0 && index < size) {
+                // check if card is compatilbe with played card
+                card temp = curr_player->peek(index);
+                if (temp == played_card) {
+                    COLOR temp_color = wild;
+                    // check if card is a wild card
+                    if (temp.color() == wild) {
+                        int check_color = 0;
+                        string str_color;
+                        while (check_color == 0) {
+                            // ask for new color
+                            renderer->message("Please choose a color (red , green, blue, yellow) :");
+                            renderer->flush();
+                            cin >> str_color;
+                            // change string to enum type COLOR
+                            temp_color = FromString(str_color);
+                            // check if valid color
+                            if (temp_color != wild) {
+                                check_color = 1;
+                            } else {
+                                renderer->message("invalid color");
+                            }
+
+                        }
+                    }
+                    engine.step(Move(play_card, index, temp_color));
+                    check_flag = 1;
+                } else {
+                    INSTR_COUNT(counter_invalid_moves);
+                    renderer->message("card cannot be played ");
+                }
+            } else {
+                INSTR_COUNT(counter_invalid_moves);
+                renderer->message("invalid index ");
+            }
+        }
+
+        if (undo) {
+            continue;
+        }
+
+
+        // check if there is a winner, and break while loop
+        if (engine.is_over()) {
+            renderer->message("PLAYER " + to_string(engine.get_winner() + 1) + " has won the game.");
+            break;
+        }
+
+
+        // the card counts, the played card and the seating order the engine built once for the whole game
+        renderer->summary(engine);
+        if (engine.get_turn() < amount_players - amount_bots) {
+            confirm_turn(*renderer, engine.get_turn() + 1);
+        }
+
+    }
+    renderer->flush();
+
+
+
+    return 0;
+}
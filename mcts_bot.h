@@ -0,0 +1,226 @@
+/*
+ * File:   mcts_bot.h
+ *
+ * Monte Carlo Tree Search player for the headless engine.
+ */
+
+#ifndef MCTS_BOT_H
+#define MCTS_BOT_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "game_engine.h"
+#include "rng.h"
+#include "thread_pool.h"
+
+struct MctsConfig {
+    int iterations; // playouts per decision over all threads, 0 for no limit
+    double time_ms; // time per decision, 0 for no limit
+    int threads;
+    double exploration;
+
+    MctsConfig() : iterations(10000), time_ms(0), threads(1), exploration(0.7) {
+    }
+};
+
+// Function to name a move by what it does rather than by hand position, so it means the same in every determinization
+
+inline int move_key(const GameEngine& engine, const Move& move) {
+    if (move.type != play_card) {
+        return move.type;
+    }
+    card temp = engine.get_player(engine.get_turn()).peek(move.index);
+    return ((temp.get_code() * 8 + move.color) << 2) | play_card;
+}
+
+/**
+ * Class: MctsBot
+ * Description:
+ * Single-observer information set MCTS. Every iteration copies the real
+ * position, determinizes it (the cards the bot cannot see are dealt out
+ * again at random, see GameEngine::determinize), walks the tree with UCB
+ * over the moves that are legal in that deal, adds one node and finishes the
+ * game with simple_policy. Tree nodes are keyed by move_key so that one tree
+ * collects statistics over all deals; availability counts replace the parent
+ * visit count in UCB, as moves are not legal in every deal.
+ *
+ * The search is root parallel: every thread grows its own tree with its own
+ * random stream, and the root visit counts are summed at the end, so threads
+ * share nothing while searching. Trees and engines are kept between
+ * decisions to avoid allocation.
+ *
+ * Functionality:
+ * - `choose`: Searches the current position and returns the move to play.
+ * - `get_playouts`: Gets the number of playouts of the last decision.
+ */
+class MctsBot {
+public:
+
+    MctsBot(const MctsConfig& config, uint64_t seed) : config(config), pool(config.threads), workers(pool.get_threads()), seed(seed), decisions(0), playouts(0) {
+        if (this->config.iterations <= 0 && this->config.time_ms <= 0) {
+            this->config.iterations = MctsConfig().iterations;
+        }
+    }
+
+    Move choose(const GameEngine& engine) {
+        std::vector<Move> moves = engine.legal_moves();
+        if (moves.size() == 1) {
+            playouts = 0;
+            return moves[0];
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds((long long) (config.time_ms * 1000));
+        int threads = pool.get_threads();
+        long long per_thread = config.iterations > 0 ? (config.iterations + threads - 1) / threads : -1;
+        uint64_t decision_seed = game_seed(seed, decisions++);
+
+        // one task per tree: a pool thread that runs out of work steals the next task, so index by task, not thread
+        pool.run(threads, [&](int, uint32_t task) {
+            workers[task].search(engine, config, per_thread, config.time_ms > 0, deadline, game_seed(decision_seed, task));
+        });
+
+        // sum the root statistics of every tree and play the most visited move
+        playouts = 0;
+        int best = 0;
+        long long best_visits = -1;
+        for (size_t m = 0; m < moves.size(); m++) {
+            int key = move_key(engine, moves[m]);
+            long long visits = 0;
+            for (int w = 0; w < threads; w++) {
+                visits += workers[w].root_visits(key);
+            }
+            playouts += visits;
+            if (visits > best_visits) {
+                best_visits = visits;
+                best = m;
+            }
+        }
+        return moves[best];
+    }
+
+    long long get_playouts() const {
+        return playouts;
+    }
+
+private:
+
+    struct Node {
+        int key; // move that leads here
+        int mover; // seat that made that move
+        int parent;
+        int first_child;
+        int next_sibling;
+        int visits;
+        int availability;
+        double wins;
+    };
+
+    struct alignas(64) Worker {
+        std::vector<Node> tree;
+        std::vector<Move> moves;
+        std::vector<int> keys;
+        std::vector<int> untried;
+        GameEngine engine;
+        Rng rng;
+
+        template <class Clock>
+        void search(const GameEngine& root, const MctsConfig& config, long long iterations, bool timed, Clock deadline, uint64_t seed) {
+            rng.seed(seed);
+            tree.clear();
+            tree.push_back(Node{-1, -1, -1, -1, -1, 0, 0, 0});
+            int observer = root.get_turn();
+
+            for (long long it = 0; iterations < 0 || it < iterations; it++) {
+                if (timed && (it & 15) == 0 && std::chrono::steady_clock::now() >= deadline) {
+                    break;
+                }
+                engine.copy_state(root);
+                engine.determinize(observer, rng);
+
+                // selection and expansion
+                int node = 0;
+                while (!engine.is_over()) {
+                    engine.legal_moves(moves);
+                    keys.resize(moves.size());
+                    untried.clear();
+                    for (size_t m = 0; m < moves.size(); m++) {
+                        keys[m] = move_key(engine, moves[m]);
+                        if (find_child(node, keys[m]) < 0) {
+                            untried.push_back(m);
+                        }
+                    }
+                    int mover = engine.get_turn();
+                    if (!untried.empty()) {
+                        int m = untried[rng.bounded(untried.size())];
+                        node = add_child(node, keys[m], mover);
+                        engine.step(moves[m]);
+                        break;
+                    }
+
+                    int best = -1;
+                    size_t best_move = 0;
+                    double best_score = -1;
+                    for (size_t m = 0; m < moves.size(); m++) {
+                        int child = find_child(node, keys[m]);
+                        Node& c = tree[child];
+                        c.availability++;
+                        double score = c.wins / c.visits + config.exploration * std::sqrt(std::log((double) c.availability) / c.visits);
+                        if (score > best_score) {
+                            best_score = score;
+                            best = child;
+                            best_move = m;
+                        }
+                    }
+                    node = best;
+                    engine.step(moves[best_move]);
+                }
+
+                // playout
+                while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+                    engine.step(simple_policy(engine));
+                }
+
+                // backpropagation, every node scores for the seat that moved into it
+                int winner = engine.get_winner();
+                for (int n = node; n >= 0; n = tree[n].parent) {
+                    tree[n].visits++;
+                    if (tree[n].mover == winner) {
+                        tree[n].wins += 1;
+                    }
+                }
+            }
+        }
+
+        int find_child(int node, int key) const {
+            for (int child = tree[node].first_child; child >= 0; child = tree[child].next_sibling) {
+                if (tree[child].key == key) {
+                    return child;
+                }
+            }
+            return -1;
+        }
+
+        int add_child(int node, int key, int mover) {
+            int child = tree.size();
+            tree.push_back(Node{key, mover, node, -1, tree[node].first_child, 0, 1, 0});
+            tree[node].first_child = child;
+            return child;
+        }
+
+        long long root_visits(int key) const {
+            int child = find_child(0, key);
+            return child < 0 ? 0 : tree[child].visits;
+        }
+    };
+
+    MctsConfig config;
+    WorkStealingPool pool;
+    std::vector<Worker> workers;
+    uint64_t seed;
+    uint64_t decisions;
+    long long playouts;
+};
+
+#endif /* MCTS_BOT_H */
@@ -0,0 +1,203 @@
+/*
+ * File:   player.h
+ *
+ * A player's hand of UNO cards.
+ */
+
+#ifndef PLAYER_H
+#define PLAYER_H
+
+#include <cstdint>
+#include <iostream>
+#include "card.h"
+
+/**
+ * Class: player
+ * Description:
+ * The `player` class represents a player in the UNO game. It manages the player's hand,
+ * which is a collection of UNO cards. The class provides functionalities to add, remove,
+ * and manipulate cards in the player's hand.
+ *
+ * Purpose and Reasoning:
+ * In the UNO game, players need a way to hold and manage their cards. The hand is stored
+ * as a count per packed card code (a 16 x 5 number/color matrix) plus a presence bitmask
+ * over the same codes. Adding and removing a card is a counter update, the whole hand is
+ * a flat block of about a hundred bytes that copies with a memcpy, and asking whether any
+ * card fits the top card is one AND with the card's PLAYABLE mask.
+ *
+ * Positions are a view on top of the counts: the hand is listed in card code order
+ * (wilds first, then red, green, blue and yellow, each by number), and position `pos`
+ * is the pos-th card of that listing. `peek`, `hand_remove` and `print` use it.
+ *
+ * Key Functionality:
+ * - `hand_add`: Adds a card to the player's hand.
+ * - `hand_remove`: Removes a card from the player's hand at a specified position.
+ * - `hand_remove_card`: Removes one copy of a given card from the player's hand.
+ * - `print`: Displays the cards in the player's hand to the console.
+ * - `get_size`: Gets the current size of the player's hand.
+ * - `peek`: Retrieves a card from the player's hand without removing it.
+ * - `get_cards`: Copies out the whole hand in position order.
+ * - `index_of`: Gets the position of the first copy of a card.
+ * - `count`: Gets how many copies of a card are held.
+ * - `color_count`: Gets how many cards of a color are held.
+ * - `card_mask`: Gets the codes of all held cards.
+ * - `playable_mask`: Gets the codes of the held cards that fit on a top card.
+ * - `has_playable`: Checks whether any held card fits on a top card.
+ *
+ *  This class is designed to be part of a larger UNO game implementation,
+ * and it works in conjunction with the `card` class and potentially a `deck` class.
+ */
+
+class player {
+public:
+
+    player() : counts(), present(), colors(), size(0) {
+    }
+
+    // Function to add a card to the player's hand
+
+    void hand_add(card temp_card) {
+        int code = temp_card.get_code();
+        counts[code]++;
+        present[code >> 6] |= 1ULL << (code & 63);
+        colors[temp_card.color()]++;
+        size++;
+    }
+
+    // Function to remove a card from the player's hand at a specified position
+
+    card hand_remove(int pos) {
+        if (pos < 0 || pos >= size) {
+            return card();
+        }
+
+        card temp_card = peek(pos);
+        hand_remove_card(temp_card);
+        return temp_card;
+    }
+
+    // Function to remove one copy of temp_card, returns false if it is not held
+
+    bool hand_remove_card(card temp_card) {
+        int code = temp_card.get_code();
+        if (counts[code] == 0) {
+            return false;
+        }
+        counts[code]--;
+        if (counts[code] == 0) {
+            present[code >> 6] &= ~(1ULL << (code & 63));
+        }
+        colors[temp_card.color()]--;
+        size--;
+        return true;
+    }
+
+
+    // Function to print the cards in the player's hand to the console
+
+    void print() const {
+        int i = 0;
+        for (int word = 0; word < 2; word++) {
+            for (uint64_t bits = present[word]; bits != 0; bits &= bits - 1) {
+                card temp_card = from_code(word * 64 + __builtin_ctzll(bits));
+                for (int k = 0; k < counts[temp_card.get_code()]; k++) {
+                    std::cout << i + 1 << ":  " << temp_card << '\n';
+                    i++;
+                }
+            }
+        }
+        std::cout.flush();
+    }
+    // Function to get the current size of the player's hand
+
+    int get_size() const {
+        return size;
+    }
+
+    // Function to peek at a card in the player's hand without removing it
+
+    card peek(int pos) const {
+        int temp_pos = pos;
+        for (int word = 0; word < 2; word++) {
+            for (uint64_t bits = present[word]; bits != 0; bits &= bits - 1) {
+                int code = word * 64 + __builtin_ctzll(bits);
+                if (temp_pos < counts[code]) {
+                    return from_code(code);
+                }
+                temp_pos -= counts[code];
+            }
+        }
+        return card();
+    }
+
+    // Function to write the whole hand, in position order, into out and return its size
+
+    int get_cards(card* out) const {
+        int n = 0;
+        for (int word = 0; word < 2; word++) {
+            for (uint64_t bits = present[word]; bits != 0; bits &= bits - 1) {
+                int code = word * 64 + __builtin_ctzll(bits);
+                for (int k = 0; k < counts[code]; k++) {
+                    out[n++] = from_code(code);
+                }
+            }
+        }
+        return n;
+    }
+
+    // Function to get the position of the first copy of temp_card, or -1 if it is not held
+
+    int index_of(card temp_card) const {
+        int code = temp_card.get_code();
+        if (counts[code] == 0) {
+            return -1;
+        }
+        int pos = 0;
+        for (int lower = 0; lower < code; lower++) {
+            pos += counts[lower];
+        }
+        return pos;
+    }
+
+    int count(card temp_card) const {
+        return counts[temp_card.get_code()];
+    }
+
+    int color_count(COLOR col) const {
+        return colors[col];
+    }
+
+    PlayableMask card_mask() const {
+        PlayableMask result = {
+            {present[0], present[1]}
+        };
+        return result;
+    }
+
+    // Function to get the codes of the held cards that can be played on top_card
+
+    PlayableMask playable_mask(card top_card) const {
+        const PlayableMask& mask = PLAYABLE[top_card.get_code()];
+        PlayableMask result = {
+            {present[0] & mask.bits[0], present[1] & mask.bits[1]}
+        };
+        return result;
+    }
+
+    bool has_playable(card top_card) const {
+        PlayableMask mask = playable_mask(top_card);
+        return (mask.bits[0] | mask.bits[1]) != 0;
+    }
+
+    static card from_code(int code) {
+        return card(code & 15, static_cast<COLOR> (code >> 4));
+    }
+
+private:
+    uint8_t counts[CARD_CODES]; // copies held of every card code
+    uint64_t present[2]; // bit `code` is set when counts[code] > 0
+    uint8_t colors[5]; // cards held per color
+    int size;
+};
+
+#endif /* PLAYER_H */
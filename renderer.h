@@ -0,0 +1,344 @@
+/*
+ * File:   renderer.h
+ *
+ * Output of the interactive game: an ANSI terminal renderer that redraws only
+ * the lines that changed, a plain text renderer for logs and a null renderer
+ * for headless runs.
+ */
+
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "card.h"
+#include "game_engine.h"
+
+#define RENDER_RULE "===================================="
+#define RENDER_BUFFER_SIZE (1 << 16) // the plain renderer writes once this much text is waiting
+
+enum RENDER_MODE {
+    render_ansi, render_plain, render_null
+};
+
+/**
+ * Class: Frame
+ * Description:
+ * The lines of one screen. The strings are kept between frames and only
+ * overwritten, so once the first few frames have grown them building a frame
+ * allocates nothing.
+ */
+class Frame {
+public:
+
+    Frame() : size(0) {
+    }
+
+    void clear() {
+        size = 0;
+    }
+
+    // Function to start a new, empty line and return it
+
+    std::string& new_line() {
+        if (size == (int) lines.size()) {
+            lines.push_back(std::string());
+        }
+        lines[size].clear();
+        return lines[size++];
+    }
+
+    int get_size() const {
+        return size;
+    }
+
+    const std::string& line(int row) const {
+        return lines[row];
+    }
+
+private:
+    std::vector<std::string> lines;
+    int size;
+};
+
+// Functions to append numbers and cards to a line without going through a stream
+
+inline void append_int(std::string& line, int value) {
+    char digits[12];
+    int n = 0;
+    unsigned int rest = value < 0 ? 0u - (unsigned int) value : value;
+    do {
+        digits[n++] = '0' + rest % 10;
+        rest /= 10;
+    } while (rest != 0);
+    if (value < 0) {
+        line += '-';
+    }
+    while (n > 0) {
+        line += digits[--n];
+    }
+}
+
+inline void append_card(std::string& line, card temp_card) {
+    const CardName& name = card_name(temp_card);
+    line.append(name.text, name.length);
+}
+
+/**
+ * Class: Renderer
+ * Description:
+ * Everything the interactive game shows goes through a Renderer. The screens
+ * are laid out once here as Frames; the implementations only decide how a
+ * frame and the messages below it reach the terminal.
+ *
+ * Functionality:
+ * - `table`: Shows the table as the player to move sees it, their hand included.
+ * - `summary`: Shows the table between two turns, with the seating order.
+ * - `message`: Adds a line under the current frame (prompts, computer moves).
+ * - `flush`: Writes everything pending, called before reading input.
+ */
+class Renderer {
+public:
+
+    virtual ~Renderer() {
+    }
+
+    virtual void table(const GameEngine& engine) = 0;
+    virtual void summary(const GameEngine& engine) = 0;
+    virtual void message(const std::string& text) = 0;
+    virtual void flush() = 0;
+
+protected:
+
+    // Function to lay out the screen of the player to move
+
+    static void build_table(const GameEngine& engine, Frame& frame) {
+        frame.clear();
+        int turn = engine.get_turn();
+        std::string& title = frame.new_line();
+        title = "PLAYER ";
+        append_int(title, turn + 1);
+        // forced draw cards were already drawn by the engine
+        if (engine.get_forced_draw() == 2) {
+            frame.new_line() = "Forced Draw-2";
+        } else if (engine.get_forced_draw() == 4) {
+            frame.new_line() = "Forced Draw-4";
+        }
+        build_counts(engine, frame);
+        std::string& played = frame.new_line();
+        played = "Played Card: ";
+        append_card(played, engine.get_played_card());
+        std::string& owner = frame.new_line();
+        owner = "PLAYER ";
+        append_int(owner, turn + 1);
+        frame.new_line() = RENDER_RULE;
+
+        // hand positions as player::print numbers them
+        const player& hand = engine.get_player(turn);
+        card cards[DECK_SIZE];
+        int size = hand.get_cards(cards);
+        for (int i = 0; i < size; i++) {
+            std::string& line = frame.new_line();
+            append_int(line, i + 1);
+            line += ":  ";
+            append_card(line, cards[i]);
+        }
+    }
+
+    // Function to lay out the screen shown between two turns
+
+    static void build_summary(const GameEngine& engine, Frame& frame) {
+        frame.clear();
+        build_counts(engine, frame);
+        frame.new_line() = RENDER_RULE;
+        std::string& played = frame.new_line();
+        played = "Played Card: ";
+        append_card(played, engine.get_played_card());
+
+        // who sits next to whom, in the current direction of play
+        const Seating& seating = engine.get_seating();
+        bool counter_clockwise = seating.get_direction() < 0;
+        frame.new_line() = "Seating:";
+        for (int seat = 0; seat < seating.get_seats(); seat++) {
+            std::string& line = frame.new_line();
+            line = "PLAYER ";
+            append_int(line, seat + 1);
+            line += " passes to: PLAYER ";
+            append_int(line, seating.neighbour(seat, counter_clockwise) + 1);
+        }
+    }
+
+private:
+
+    static void build_counts(const GameEngine& engine, Frame& frame) {
+        frame.new_line() = "Cards remaining for each player";
+        frame.new_line() = RENDER_RULE;
+        std::string& counts = frame.new_line();
+        for (int i = 0; i < engine.get_amount_players(); i++) {
+            counts += "PLAYER ";
+            append_int(counts, i + 1);
+            counts += ": ";
+            append_int(counts, engine.get_player(i).get_size());
+            counts += "   ";
+        }
+    }
+};
+
+/**
+ * Class: AnsiRenderer
+ * Description:
+ * Draws frames in place on an ANSI terminal. The previous frame is kept, and
+ * a new one only rewrites the lines that differ: the cursor jumps to the row,
+ * the line is written and the rest of the row erased. Everything below the
+ * frame (the messages of the last turn) is erased too, and the whole update
+ * leaves in a single write. The first frame clears the screen. Rows are
+ * absolute, so a frame and its messages are expected to fit the terminal.
+ */
+class AnsiRenderer : public Renderer {
+public:
+
+    explicit AnsiRenderer(std::ostream& out) : out(out), cleared(false), current(0) {
+    }
+
+    void table(const GameEngine& engine) override {
+        build_table(engine, frames[1 - current]);
+        show();
+    }
+
+    void summary(const GameEngine& engine) override {
+        build_summary(engine, frames[1 - current]);
+        show();
+    }
+
+    void message(const std::string& text) override {
+        buffer += text;
+        buffer += '\n';
+    }
+
+    void flush() override {
+        out.write(buffer.data(), buffer.size());
+        out.flush();
+        buffer.clear();
+    }
+
+private:
+    std::ostream& out;
+    std::string buffer;
+    Frame frames[2]; // the frame on screen and the one being built
+    bool cleared;
+    int current; // index of the frame on screen
+
+    void show() {
+        const Frame& old_frame = frames[current];
+        const Frame& new_frame = frames[1 - current];
+        if (!cleared) {
+            buffer += "\x1b[2J";
+            cleared = true;
+        }
+        for (int row = 0; row < new_frame.get_size(); row++) {
+            if (row < old_frame.get_size() && old_frame.line(row) == new_frame.line(row)) {
+                continue;
+            }
+            move_to(row);
+            buffer += new_frame.line(row);
+            buffer += "\x1b[K";
+        }
+        // the cursor ends up under the frame, and everything from there down goes
+        move_to(new_frame.get_size());
+        buffer += "\x1b[J";
+        current = 1 - current;
+        flush();
+    }
+
+    void move_to(int row) {
+        buffer += "\x1b[";
+        append_int(buffer, row + 1);
+        buffer += ";1H";
+    }
+};
+
+/**
+ * Class: PlainRenderer
+ * Description:
+ * Writes every frame in full as plain lines, for logs and terminals without
+ * ANSI support. Text collects in one buffer and is written in blocks of
+ * RENDER_BUFFER_SIZE, or on flush, instead of a flush per line.
+ */
+class PlainRenderer : public Renderer {
+public:
+
+    explicit PlainRenderer(std::ostream& out) : out(out) {
+        buffer.reserve(RENDER_BUFFER_SIZE);
+    }
+
+    ~PlainRenderer() override {
+        flush();
+    }
+
+    void table(const GameEngine& engine) override {
+        build_table(engine, frame);
+        append_frame();
+    }
+
+    void summary(const GameEngine& engine) override {
+        build_summary(engine, frame);
+        append_frame();
+    }
+
+    void message(const std::string& text) override {
+        buffer += text;
+        buffer += '\n';
+        flush_if_full();
+    }
+
+    void flush() override {
+        out.write(buffer.data(), buffer.size());
+        out.flush();
+        buffer.clear();
+    }
+
+private:
+    std::ostream& out;
+    std::string buffer;
+    Frame frame;
+
+    void append_frame() {
+        for (int row = 0; row < frame.get_size(); row++) {
+            buffer += frame.line(row);
+            buffer += '\n';
+        }
+        flush_if_full();
+    }
+
+    void flush_if_full() {
+        if (buffer.size() >= RENDER_BUFFER_SIZE) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+};
+
+/**
+ * Class: NullRenderer
+ * Description:
+ * Shows nothing, for headless runs that go through the interactive loop.
+ */
+class NullRenderer : public Renderer {
+public:
+
+    void table(const GameEngine&) override {
+    }
+
+    void summary(const GameEngine&) override {
+    }
+
+    void message(const std::string&) override {
+    }
+
+    void flush() override {
+    }
+};
+
+#endif /* RENDERER_H */
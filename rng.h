@@ -0,0 +1,104 @@
+/*
+ * File:   rng.h
+ *
+ * Seedable pseudo random number generator used for every shuffle and random
+ * choice in the game, so that a game (or a whole simulation run) can be
+ * replayed bit-for-bit from its seed.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// Function to advance a splitmix64 state and return its next output
+
+inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Function to derive the seed of game number game_index of a run seeded with run_seed
+
+inline uint64_t game_seed(uint64_t run_seed, uint64_t game_index) {
+    uint64_t state = run_seed ^ (game_index * 0xd1b54a32d192ed03ULL);
+    return splitmix64(state);
+}
+
+/**
+ * Class: Rng
+ * Description:
+ * xoshiro256** generator, seeded through splitmix64 as its authors recommend.
+ * It also satisfies UniformRandomBitGenerator, so it can be handed to the
+ * standard library.
+ *
+ * Functionality:
+ * - `seed`: Restarts the sequence from a 64 bit seed.
+ * - `next`: Returns the next 64 random bits.
+ * - `bounded`: Returns an unbiased number in [0, n).
+ */
+class Rng {
+public:
+    typedef uint64_t result_type;
+
+    Rng(uint64_t seed_value = 0) {
+        seed(seed_value);
+    }
+
+    void seed(uint64_t seed_value) {
+        uint64_t state = seed_value;
+        for (int i = 0; i < 4; i++) {
+            s[i] = splitmix64(state);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Function to return a number in [0, n) without modulo bias (Lemire's multiply and reject)
+
+    uint32_t bounded(uint32_t n) {
+        uint64_t m = (next() >> 32) * n;
+        uint32_t low = (uint32_t) m;
+        if (low < n) {
+            uint32_t threshold = (0u - n) % n;
+            while (low < threshold) {
+                m = (next() >> 32) * n;
+                low = (uint32_t) m;
+            }
+        }
+        return m >> 32;
+    }
+
+    uint64_t operator()() {
+        return next();
+    }
+
+    static constexpr uint64_t min() {
+        return 0;
+    }
+
+    static constexpr uint64_t max() {
+        return ~0ULL;
+    }
+
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+#endif /* RNG_H */
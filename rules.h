@@ -0,0 +1,167 @@
+/*
+ * File:   rules.h
+ *
+ * House-rule variants as compile-time policies of the engine, and the
+ * dispatch from a variant chosen at run time to its instantiation.
+ */
+
+#ifndef RULES_H
+#define RULES_H
+
+#include <string>
+#include <utility>
+#include "card.h"
+
+/* one bit per house rule, a rule set is any combination of them */
+#define RULE_STACKING 1
+#define RULE_SEVEN_ZERO 2
+#define RULE_JUMP_IN 4
+#define RULE_DRAW_UNTIL_PLAYABLE 8
+#define RULE_VARIANTS 16
+
+/**
+ * Struct: RuleSet
+ * Description:
+ * The policy parameter of BasicEngine. Every rule is a constant the engine
+ * tests with `if constexpr`, so each combination compiles into its own
+ * engine and the rules that are off leave no code and no branch behind.
+ * RuleSet<0> is the game the interactive loop always played.
+ *
+ * - stacking: a Draw-2 may be answered with a Draw-2 and a Draw-4 with a
+ *   Draw-4, passing the growing penalty on. The player who draws instead
+ *   takes all of it and then plays the rest of the turn.
+ * - seven_zero: playing a 7 swaps hands with the opponent holding the fewest
+ *   cards (the nearest one in the direction of play on a tie), playing a 0
+ *   passes every hand one seat on in the direction of play.
+ * - jump_in: a player holding the exact card just played (not a wild) plays
+ *   it out of turn, the nearest one in the direction of play first. The turn
+ *   carries on from them, their copy taking effect in place of the first.
+ * - draw_until_playable: draw_card keeps drawing until a card that fits
+ *   comes up. A coloured one may then be played or kept as usual, a wild
+ *   one stays in the hand.
+ *
+ * Decks is how many decks are shuffled together, up to MAX_DECKS. It sets
+ * the size of the engine's piles at compile time, so a large party table
+ * keeps all of its cards inside the engine like a standard one.
+ */
+template <int Flags, int Decks = 1>
+struct RuleSet {
+    static_assert(Decks >= 1 && Decks <= MAX_DECKS, "1 to MAX_DECKS decks");
+    static constexpr int flags = Flags;
+    static constexpr int decks = Decks;
+    static constexpr bool stacking = (Flags & RULE_STACKING) != 0;
+    static constexpr bool seven_zero = (Flags & RULE_SEVEN_ZERO) != 0;
+    static constexpr bool jump_in = (Flags & RULE_JUMP_IN) != 0;
+    static constexpr bool draw_until_playable = (Flags & RULE_DRAW_UNTIL_PLAYABLE) != 0;
+};
+
+typedef RuleSet<0> StandardRules;
+
+// Function to build the mask of every card code with the given number, in any colour
+
+constexpr PlayableMask number_mask(int number) {
+    PlayableMask mask{};
+    for (int col = wild; col <= yellow; col++) {
+        int code = col * 16 + number;
+        mask.bits[code >> 6] |= 1ULL << (code & 63);
+    }
+    return mask;
+}
+
+inline const char* rule_name(int rule) {
+    switch (rule) {
+        case RULE_STACKING:
+            return "stacking";
+        case RULE_SEVEN_ZERO:
+            return "seven-zero";
+        case RULE_JUMP_IN:
+            return "jump-in";
+        case RULE_DRAW_UNTIL_PLAYABLE:
+            return "draw-until-playable";
+        default:
+            return "";
+    }
+}
+
+// Function to name a rule set, like "stacking+jump-in", or "standard" when no house rule is on
+
+inline std::string rules_name(int flags) {
+    std::string name;
+    for (int rule = 1; rule < RULE_VARIANTS; rule <<= 1) {
+        if (flags & rule) {
+            name += (name.empty() ? "" : "+");
+            name += rule_name(rule);
+        }
+    }
+    return name.empty() ? "standard" : name;
+}
+
+// Function to read a rule set written as rules_name writes it (',' separates too), returns -1 for an unknown rule
+
+inline int parse_rules(const std::string& text) {
+    if (text == "standard") {
+        return 0;
+    }
+    int flags = 0;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find_first_of("+,", start);
+        std::string part = text.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        int found = -1;
+        for (int rule = 1; rule < RULE_VARIANTS; rule <<= 1) {
+            if (part == rule_name(rule)) {
+                found = rule;
+            }
+        }
+        if (found < 0) {
+            return -1;
+        }
+        flags |= found;
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    return flags;
+}
+
+template <int Flags, class Visitor>
+auto visit_rules(Visitor& visitor) {
+    return visitor(RuleSet<Flags>());
+}
+
+template <class Visitor, int... Flags>
+auto dispatch_rules(int flags, Visitor& visitor, std::integer_sequence<int, Flags...>) {
+    typedef decltype(visitor(StandardRules())) Result;
+    static Result(* const table[])(Visitor&) = {&visit_rules<Flags, Visitor>...};
+    return table[flags](visitor);
+}
+
+// Function to call visitor with the RuleSet for flags, one indirect call picks the instantiation,
+// visitor is a generic lambda taking the rule set by value: [&](auto rules) { ... decltype(rules) ... }
+
+template <class Visitor>
+auto dispatch_rules(int flags, Visitor visitor) {
+    return dispatch_rules(flags, visitor, std::make_integer_sequence<int, RULE_VARIANTS>());
+}
+
+template <int Decks, class Visitor>
+auto visit_decks(Visitor& visitor) {
+    return visitor(RuleSet<0, Decks + 1>());
+}
+
+template <class Visitor, int... Decks>
+auto dispatch_decks(int decks, Visitor& visitor, std::integer_sequence<int, Decks...>) {
+    typedef decltype(visitor(StandardRules())) Result;
+    static Result(* const table[])(Visitor&) = {&visit_decks<Decks, Visitor>...};
+    return table[decks - 1](visitor);
+}
+
+// Function to call visitor with the standard rules played with decks decks, 1 to MAX_DECKS, like dispatch_rules
+
+template <class Visitor>
+auto dispatch_decks(int decks, Visitor visitor) {
+    return dispatch_decks(decks, visitor, std::make_integer_sequence<int, MAX_DECKS>());
+}
+
+#endif /* RULES_H */
@@ -0,0 +1,98 @@
+/*
+ * File:   seating.h
+ *
+ * Seating order of a table and whose turn it is.
+ */
+
+#ifndef SEATING_H
+#define SEATING_H
+
+#include <cstdint>
+
+#define MAX_SEATS 64
+
+/**
+ * Class: Seating
+ * Description:
+ * The ring of seats around a table, built once per game. For every seat the
+ * neighbour in each direction is stored in a flat array, so moving on is one
+ * table lookup whatever the table size, and the index always stays in
+ * [0, seats). The direction is a single bit that reverse flips.
+ *
+ * Functionality:
+ * - `build`: Seats `seats` players and gives the turn to `first`.
+ * - `next`: Moves the turn one seat on in the current direction.
+ * - `skip`: Moves the turn two seats on, jumping over the next player.
+ * - `reverse`: Flips the direction of play.
+ * - `jump_to`: Gives the turn to any seat, for a player who jumps in.
+ * - `peek_next`: Gets the seat `steps` seats on without moving.
+ * - `neighbour`: Gets the seat next to any seat in either direction.
+ */
+class Seating {
+public:
+
+    Seating() : seats(0), current(0), direction(0) {
+    }
+
+    void build(int seats, int first) {
+        this->seats = seats;
+        for (int seat = 0; seat < seats; seat++) {
+            next_seat[0][seat] = (seat + 1) % seats;
+            next_seat[1][seat] = (seat + seats - 1) % seats;
+        }
+        current = first;
+        direction = 0;
+    }
+
+    void next() {
+        current = next_seat[direction][current];
+    }
+
+    void skip() {
+        current = next_seat[direction][next_seat[direction][current]];
+    }
+
+    void reverse() {
+        direction ^= 1;
+    }
+
+    void jump_to(int seat) {
+        current = seat;
+    }
+
+    int peek_next(int steps = 1) const {
+        int seat = current;
+        for (int i = 0; i < steps; i++) {
+            seat = next_seat[direction][seat];
+        }
+        return seat;
+    }
+
+    // Function to get the seat next to seat, clockwise when counter_clockwise is false
+
+    int neighbour(int seat, bool counter_clockwise) const {
+        return next_seat[counter_clockwise][seat];
+    }
+
+    int get_current() const {
+        return current;
+    }
+
+    int get_seats() const {
+        return seats;
+    }
+
+    // 1 for clockwise, -1 for counter clockwise
+
+    int get_direction() const {
+        return direction == 0 ? 1 : -1;
+    }
+
+private:
+    uint8_t next_seat[2][MAX_SEATS]; // [direction][seat], direction 0 is clockwise
+    int seats;
+    int current;
+    int direction;
+};
+
+#endif /* SEATING_H */
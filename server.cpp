@@ -0,0 +1,52 @@
+/*
+ * File:   server.cpp
+ *
+ * The multi-table game server, see game_server.h for how it works and
+ * local_socket.h for the protocol.
+ *
+ * usage: uno_server [address] [move timeout ms]
+ *
+ * The address is unix:<path> (default unix:/tmp/uno.sock) or tcp:<port> on
+ * 127.0.0.1. SIGINT and SIGTERM stop the server.
+ */
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "game_server.h"
+using namespace std;
+
+static GameServer* running_server = NULL;
+
+void stop_server(int) {
+    if (running_server != NULL) {
+        running_server->stop();
+    }
+}
+
+int main(int argc, char** argv) {
+    string text = argc > 1 ? argv[1] : "unix:/tmp/uno.sock";
+    int timeout_ms = argc > 2 ? atoi(argv[2]) : SERVER_MOVE_TIMEOUT_MS;
+    LocalAddress address;
+    if (!address.parse(text) || timeout_ms <= 0) {
+        cerr << "usage: uno_server [unix:<path> | tcp:<port>] [move timeout ms]" << endl;
+        return 2;
+    }
+
+    GameServer server(timeout_ms);
+    if (!server.start(address)) {
+        cerr << "cannot listen on " << text << endl;
+        return 1;
+    }
+    running_server = &server;
+    struct sigaction action = {};
+    action.sa_handler = stop_server;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    cout << "serving on " << text << ", " << timeout_ms << " ms per move" << endl;
+    server.run();
+    cout << "stopped" << endl;
+    return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * File:   simulation_runner.h
+ *
+ * Multi-core Monte Carlo runner: spreads batches of headless games over a
+ * WorkStealingPool and merges the per-worker results (or statistics) at the
+ * end.
+ */
+
+#ifndef SIMULATION_RUNNER_H
+#define SIMULATION_RUNNER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "event_bus.h"
+#include "game_engine.h"
+#include "game_stats.h"
+#include "thread_pool.h"
+
+#define GAMES_PER_BATCH 1024
+
+/**
+ * Everything a worker touches while playing: its own engine (and with it its
+ * own random generator) and its own running totals. Padded to a cache line so
+ * that workers never write to the same line.
+ */
+struct alignas(64) SimulationWorker {
+    GameEngine engine;
+    SimulationResult result;
+};
+
+// Function to play n_games games on every worker of pool, seeded exactly like run_games,
+// so the merged result does not depend on the number of threads
+
+inline SimulationResult run_games_parallel(long long n_games, uint64_t seed, int amount_players, WorkStealingPool& pool) {
+    std::vector<SimulationWorker> workers(pool.get_threads());
+    uint32_t n_batches = (n_games + GAMES_PER_BATCH - 1) / GAMES_PER_BATCH;
+
+    pool.run(n_batches, [&](int w, uint32_t batch) {
+        SimulationWorker& worker = workers[w];
+        long long first = (long long) batch * GAMES_PER_BATCH;
+        long long last = std::min(first + GAMES_PER_BATCH, n_games);
+        for (long long i = first; i < last; i++) {
+            play_game(worker.engine, amount_players, game_seed(seed, i), worker.result);
+        }
+    });
+
+    SimulationResult result;
+    for (const SimulationWorker& worker : workers) {
+        result.merge(worker.result);
+    }
+    return result;
+}
+
+struct alignas(64) StatsWorker {
+    GameEngine engine;
+    GameStats stats;
+};
+
+// Function to play n_games games like run_games_parallel and gather their GameStats, every worker
+// into its own, merged once all games are done
+
+inline GameStats collect_stats(long long n_games, uint64_t seed, int amount_players, WorkStealingPool& pool) {
+    std::vector<StatsWorker> workers(pool.get_threads());
+    uint32_t n_batches = (n_games + GAMES_PER_BATCH - 1) / GAMES_PER_BATCH;
+
+    pool.run(n_batches, [&](int w, uint32_t batch) {
+        StatsWorker& worker = workers[w];
+        long long first = (long long) batch * GAMES_PER_BATCH;
+        long long last = std::min(first + GAMES_PER_BATCH, n_games);
+        for (long long i = first; i < last; i++) {
+            GameEngine& engine = worker.engine;
+            engine.new_game(amount_players, game_seed(seed, i));
+            int first_player = engine.get_turn();
+            while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+                engine.step(simple_policy(engine));
+            }
+            worker.stats.add(engine, first_player);
+        }
+    });
+
+    GameStats stats;
+    for (const StatsWorker& worker : workers) {
+        stats.merge(worker.stats);
+    }
+    return stats;
+}
+
+typedef BasicEngine<StandardRules, BusSink> ObservedEngine;
+
+struct alignas(64) ObservedWorker {
+    ObservedEngine engine;
+    SimulationResult result;
+};
+
+// Function to play the games of run_games_parallel with every event going to bus, worker w on producer
+// lane w, the bus needs a lane for every thread of pool and must be started
+
+inline SimulationResult run_games_on_bus(long long n_games, uint64_t seed, int amount_players, WorkStealingPool& pool, EventBus& bus) {
+    std::vector<ObservedWorker> workers(pool.get_threads());
+    for (int w = 0; w < pool.get_threads(); w++) {
+        workers[w].engine.get_events() = bus.sink(w);
+    }
+    uint32_t n_batches = (n_games + GAMES_PER_BATCH - 1) / GAMES_PER_BATCH;
+
+    pool.run(n_batches, [&](int w, uint32_t batch) {
+        ObservedWorker& worker = workers[w];
+        long long first = (long long) batch * GAMES_PER_BATCH;
+        long long last = std::min(first + GAMES_PER_BATCH, n_games);
+        for (long long i = first; i < last; i++) {
+            play_game(worker.engine, amount_players, game_seed(seed, i), worker.result);
+        }
+    });
+
+    SimulationResult result;
+    for (const ObservedWorker& worker : workers) {
+        result.merge(worker.result);
+    }
+    return result;
+}
+
+#endif /* SIMULATION_RUNNER_H */
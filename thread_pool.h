@@ -0,0 +1,232 @@
+/*
+ * File:   thread_pool.h
+ *
+ * Work-stealing scheduler for batches of independent tasks (games, playouts).
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * Class: WorkStealingPool
+ * Description:
+ * Runs tasks 0 .. n_tasks-1 on a fixed number of worker threads. Every worker
+ * starts with an equal slice of the task range. A worker takes tasks from the
+ * front of its own slice, and once the slice is empty it steals the back half
+ * of another worker's slice. A slice is a [begin, end) pair packed into one
+ * atomic word, so taking and stealing are a single compare-and-swap and no
+ * lock is taken while tasks run.
+ *
+ * The calling thread is worker 0. The other workers are started once, by the
+ * constructor, and sleep on a condition variable between runs: `run` bumps a
+ * generation counter to wake them and waits until each of them has found
+ * nothing left to take or steal, so a run costs a wake-up instead of a thread
+ * start per worker.
+ *
+ * Functionality:
+ * - `run`: Runs fn(worker, task) for every task and returns when all are done.
+ * - `get_threads`: Gets the number of worker threads.
+ */
+class WorkStealingPool {
+public:
+
+    WorkStealingPool(int threads, bool pin = false) : threads(threads < 1 ? 1 : threads), pin(pin), slices(this->threads),
+    generation(0), busy(0), stopping(false), job(NULL), job_fn(NULL) {
+        for (int w = 1; w < this->threads; w++) {
+            workers.emplace_back([this, w]() {
+                wait_for_runs(w);
+            });
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) {
+            t.join();
+        }
+    }
+
+    int get_threads() const {
+        return threads;
+    }
+
+    // Function to run fn(worker, task) for every task in [0, n_tasks), n_tasks must fit in 32 bits
+
+    template <class F>
+    void run(uint32_t n_tasks, F fn) {
+        for (int w = 0; w < threads; w++) {
+            uint32_t begin = (uint64_t) n_tasks * w / threads;
+            uint32_t end = (uint64_t) n_tasks * (w + 1) / threads;
+            slices[w].range.store(pack(begin, end));
+        }
+
+#ifdef __linux__
+        // the calling thread is worker 0, give it back its affinity afterwards
+        cpu_set_t caller_set;
+        pthread_getaffinity_np(pthread_self(), sizeof (caller_set), &caller_set);
+#endif
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &run_job<F>;
+            job_fn = &fn;
+            busy = threads - 1;
+            generation++;
+        }
+        wake.notify_all();
+        pin_to_cpu(0);
+        work(0, fn);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this]() {
+                return busy == 0;
+            });
+        }
+#ifdef __linux__
+        if (pin) {
+            pthread_setaffinity_np(pthread_self(), sizeof (caller_set), &caller_set);
+        }
+#endif
+    }
+
+private:
+
+    struct alignas(64) Slice {
+        std::atomic<uint64_t> range;
+    };
+
+    int threads;
+    bool pin;
+    std::vector<Slice> slices;
+    std::vector<std::thread> workers; // workers 1 .. threads-1
+    std::mutex mutex; // guards everything below
+    std::condition_variable wake; // the workers wait here for the next generation
+    std::condition_variable done; // run waits here for busy to reach 0
+    uint64_t generation; // number of runs started
+    int busy; // workers that have not finished the current run yet
+    bool stopping;
+    void (*job)(WorkStealingPool*, void*, int); // work() for the type of fn of the current run
+    void* job_fn;
+
+    template <class F>
+    static void run_job(WorkStealingPool* pool, void* fn, int w) {
+        pool->work(w, *static_cast<F*> (fn));
+    }
+
+    // Function to run on worker w's own thread: sleep until a run starts, join it, report back, and again
+
+    void wait_for_runs(int w) {
+        pin_to_cpu(w);
+        uint64_t seen = 0;
+        for (;;) {
+            void (*current)(WorkStealingPool*, void*, int);
+            void* current_fn;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this, seen]() {
+                    return stopping || generation != seen;
+                });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+                current = job;
+                current_fn = job_fn;
+            }
+            current(this, current_fn, w);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy == 0) {
+                done.notify_one();
+            }
+        }
+    }
+
+    void pin_to_cpu(int w) {
+#ifdef __linux__
+        if (pin) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(w % std::max(1u, std::thread::hardware_concurrency()), &set);
+            pthread_setaffinity_np(pthread_self(), sizeof (set), &set);
+        }
+#else
+        (void) w;
+#endif
+    }
+
+    static uint64_t pack(uint32_t begin, uint32_t end) {
+        return ((uint64_t) begin << 32) | end;
+    }
+
+    // Function to take the next task from the front of the worker's own slice
+
+    bool pop(int w, uint32_t& task) {
+        uint64_t range = slices[w].range.load(std::memory_order_relaxed);
+        for (;;) {
+            uint32_t begin = range >> 32;
+            uint32_t end = (uint32_t) range;
+            if (begin >= end) {
+                return false;
+            }
+            if (slices[w].range.compare_exchange_weak(range, pack(begin + 1, end), std::memory_order_acquire)) {
+                task = begin;
+                return true;
+            }
+        }
+    }
+
+    // Function to move the back half of another worker's slice into the worker's own (empty) slice
+
+    bool steal(int w) {
+        for (int i = 1; i < threads; i++) {
+            Slice& victim = slices[(w + i) % threads];
+            uint64_t range = victim.range.load(std::memory_order_relaxed);
+            for (;;) {
+                uint32_t begin = range >> 32;
+                uint32_t end = (uint32_t) range;
+                if (begin >= end) {
+                    break;
+                }
+                uint32_t mid = begin + (end - begin) / 2;
+                if (victim.range.compare_exchange_weak(range, pack(begin, mid), std::memory_order_acq_rel)) {
+                    slices[w].range.store(pack(mid, end), std::memory_order_release);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    template <class F>
+    void work(int w, F& fn) {
+        uint32_t task;
+        for (;;) {
+            while (pop(w, task)) {
+                fn(w, task);
+            }
+            if (!steal(w)) {
+                return;
+            }
+        }
+    }
+};
+
+#endif /* THREAD_POOL_H */
@@ -0,0 +1,453 @@
+/*
+ * File:   tournament.h
+ *
+ * A persistent registry of rated players (bots) kept in flat arrays, Swiss
+ * and round-robin pairing, and tournament rounds whose tables are played in
+ * parallel and rated in one batch afterwards.
+ */
+
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "game_engine.h"
+#include "game_record.h"
+#include "rng.h"
+#include "thread_pool.h"
+
+#define REGISTRY_MAGIC "UNOREG01"
+#define RATING_START 1500.0
+#define RD_START 350.0 // Glicko rating deviation of a new player, also the most it grows back to
+#define RD_GROWTH 30.0 // how much a deviation grows per round, Glicko's c
+#define ELO_K 16.0
+#define SWISS_WINDOW 16 // players looked ahead to avoid seating last round's table together again
+#define TABLES_PER_TASK 64 // tables one pool task plays
+
+/**
+ * Class: PlayerRegistry
+ * Description:
+ * Every entrant of every tournament, one slot per player in each of a set of
+ * parallel arrays (structure of arrays). A player's id is its slot and never
+ * changes, so tables, results and pairings refer to players by plain 32-bit
+ * ids, and a pass over one field, like sorting by score or aging every
+ * deviation, only streams that one array.
+ *
+ * A player keeps an Elo rating and a Glicko rating with its deviation, the
+ * games and wins of its career, its score in the current tournament and the
+ * table it sat at last round. The `skill` of a bot is the chance it plays
+ * simple_policy's move, otherwise it plays a random legal move.
+ *
+ * Functionality:
+ * - `add`: Registers a player and returns its id.
+ * - `size`: Gets the number of players.
+ * - `reset_scores`: Starts a new tournament for everybody.
+ * - `save` / `load`: Writes or reads the whole registry, little endian like game records.
+ */
+class PlayerRegistry {
+public:
+    std::vector<float> skill;
+    std::vector<double> elo;
+    std::vector<double> rating; // Glicko
+    std::vector<double> deviation; // Glicko RD
+    std::vector<uint32_t> games;
+    std::vector<uint32_t> wins;
+    std::vector<uint32_t> score; // wins in the current tournament
+    std::vector<int32_t> last_table; // -1 before the first round of a tournament
+
+    uint32_t add(float bot_skill) {
+        skill.push_back(bot_skill);
+        elo.push_back(RATING_START);
+        rating.push_back(RATING_START);
+        deviation.push_back(RD_START);
+        games.push_back(0);
+        wins.push_back(0);
+        score.push_back(0);
+        last_table.push_back(-1);
+        return skill.size() - 1;
+    }
+
+    uint32_t size() const {
+        return skill.size();
+    }
+
+    void reset_scores() {
+        std::fill(score.begin(), score.end(), 0);
+        std::fill(last_table.begin(), last_table.end(), -1);
+    }
+
+    bool save(const char* path) const {
+        FILE* file = fopen(path, "wb");
+        if (file == NULL) {
+            return false;
+        }
+        uint8_t header[16];
+        memcpy(header, REGISTRY_MAGIC, 8);
+        put_u64(header + 8, size());
+        bool ok = fwrite(header, 1, 16, file) == 16;
+        // 36 bytes per player: skill, elo, rating and deviation as IEEE bits, games, wins
+        std::vector<uint8_t> buffer(36 * (size_t) size());
+        for (uint32_t id = 0; id < size(); id++) {
+            uint8_t* out = &buffer[36 * (size_t) id];
+            put_u32(out, float_bits(skill[id]));
+            put_u64(out + 4, double_bits(elo[id]));
+            put_u64(out + 12, double_bits(rating[id]));
+            put_u64(out + 20, double_bits(deviation[id]));
+            put_u32(out + 28, games[id]);
+            put_u32(out + 32, wins[id]);
+        }
+        ok = ok && fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        return fclose(file) == 0 && ok;
+    }
+
+    bool load(const char* path) {
+        FILE* file = fopen(path, "rb");
+        if (file == NULL) {
+            return false;
+        }
+        // the player count must fit in the file before anything is allocated for it
+        long file_size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+        uint8_t header[16];
+        if (file_size < 16 || fseek(file, 0, SEEK_SET) != 0 || fread(header, 1, 16, file) != 16
+                || memcmp(header, REGISTRY_MAGIC, 8) != 0) {
+            fclose(file);
+            return false;
+        }
+        uint64_t count = get_u64(header + 8);
+        if (count > (uint64_t) (file_size - 16) / 36) {
+            fclose(file);
+            return false;
+        }
+        std::vector<uint8_t> buffer(36 * count);
+        bool ok = fread(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        fclose(file);
+        if (!ok) {
+            return false;
+        }
+        *this = PlayerRegistry();
+        for (uint64_t id = 0; id < count; id++) {
+            const uint8_t* in = &buffer[36 * id];
+            add(bits_float(get_u32(in)));
+            elo[id] = bits_double(get_u64(in + 4));
+            rating[id] = bits_double(get_u64(in + 12));
+            deviation[id] = bits_double(get_u64(in + 20));
+            games[id] = get_u32(in + 28);
+            wins[id] = get_u32(in + 32);
+        }
+        return true;
+    }
+
+private:
+
+    static uint32_t float_bits(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, 4);
+        return bits;
+    }
+
+    static float bits_float(uint32_t bits) {
+        float value;
+        memcpy(&value, &bits, 4);
+        return value;
+    }
+
+    static uint64_t double_bits(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, 8);
+        return bits;
+    }
+
+    static double bits_double(uint64_t bits) {
+        double value;
+        memcpy(&value, &bits, 8);
+        return value;
+    }
+};
+
+/**
+ * Struct: Round
+ * Description:
+ * The tables of one round as a flat list of player ids: table t seats
+ * players[starts[t]] .. players[starts[t + 1] - 1], in seat order. `byes`
+ * are the players left without a table.
+ */
+struct Round {
+    std::vector<uint32_t> players;
+    std::vector<uint32_t> starts;
+    std::vector<uint32_t> byes;
+
+    int tables() const {
+        return starts.empty() ? 0 : starts.size() - 1;
+    }
+
+    int seats(int table) const {
+        return starts[table + 1] - starts[table];
+    }
+
+    void clear() {
+        players.clear();
+        starts.assign(1, 0);
+        byes.clear();
+    }
+};
+
+// Function to pair a Swiss round: players with the same score (then the closest ratings) sit together at
+// tables of `seats`, looking up to SWISS_WINDOW players ahead for someone who did not share a table with
+// them last round. A last table of at least two takes whoever is left, a single player left gets a bye.
+
+inline void pair_swiss(const PlayerRegistry& registry, int seats, Round& round) {
+    uint32_t n = registry.size();
+    // score, then Glicko rating in 1/16 points, then id, in one key sorted descending
+    std::vector<uint64_t> keys(n);
+    for (uint32_t id = 0; id < n; id++) {
+        double clamped = std::min(std::max(registry.rating[id], 0.0), 65535.0);
+        uint64_t rating_key = (uint64_t) (clamped * 16) & 0xFFFFF;
+        keys[id] = ((uint64_t) std::min(registry.score[id], 4095U) << 52) | (rating_key << 32) | (0xFFFFFFFFU - id);
+    }
+    std::sort(keys.begin(), keys.end(), [](uint64_t a, uint64_t b) {
+        return a > b;
+    });
+    std::vector<uint32_t> order(n);
+    for (uint32_t i = 0; i < n; i++) {
+        order[i] = 0xFFFFFFFFU - (uint32_t) keys[i];
+    }
+
+    round.clear();
+    round.players.reserve(n);
+    std::vector<uint8_t> seated(n, 0);
+    uint32_t next = 0; // first position in order not seated yet
+    uint32_t left = n;
+    while (left >= 2) {
+        int table_seats = left >= (uint32_t) seats ? seats : left;
+        while (seated[next]) {
+            next++;
+        }
+        size_t table_start = round.players.size();
+        round.players.push_back(order[next]);
+        seated[next] = 1;
+        for (int s = 1; s < table_seats; s++) {
+            uint32_t pick = n;
+            uint32_t first_free = n;
+            int looked = 0;
+            for (uint32_t pos = next + 1; pos < n && looked < SWISS_WINDOW; pos++) {
+                if (seated[pos]) {
+                    continue;
+                }
+                first_free = std::min(first_free, pos);
+                looked++;
+                int32_t table = registry.last_table[order[pos]];
+                bool met = false;
+                for (size_t k = table_start; k < round.players.size() && table >= 0; k++) {
+                    met = met || registry.last_table[round.players[k]] == table;
+                }
+                if (!met) {
+                    pick = pos;
+                    break;
+                }
+            }
+            pick = pick < n ? pick : first_free;
+            round.players.push_back(order[pick]);
+            seated[pick] = 1;
+        }
+        round.starts.push_back(round.players.size());
+        left -= table_seats;
+    }
+    for (uint32_t pos = next; pos < n; pos++) {
+        if (!seated[pos]) {
+            round.byes.push_back(order[pos]);
+        }
+    }
+}
+
+// Function to pair round r (from 0) of a heads-up round robin of everybody by the circle method: player 0
+// stays put and the others turn one place per round, so n - 1 rounds (n when n is odd) meet every pair once
+
+inline void pair_round_robin(uint32_t n, uint32_t r, Round& round) {
+    round.clear();
+    uint32_t slots = n + (n & 1); // an odd field gets a dummy, whoever meets it has a bye
+    uint32_t turning = slots - 1;
+    for (uint32_t i = 0; i < slots / 2; i++) {
+        uint32_t a = i == 0 ? 0 : (i - 1 + r) % turning + 1;
+        uint32_t b = (slots - 2 - i + r) % turning + 1;
+        if (a >= n || b >= n) {
+            round.byes.push_back(a < n ? a : b);
+            continue;
+        }
+        round.players.push_back(a);
+        round.players.push_back(b);
+        round.starts.push_back(round.players.size());
+    }
+}
+
+/**
+ * Class: Tournament
+ * Description:
+ * Plays rounds for a PlayerRegistry. The tables of a round are spread over a
+ * WorkStealingPool in tasks of TABLES_PER_TASK, every table seeded from the
+ * tournament seed, the round and its index, so the outcome does not depend
+ * on the number of threads. Each table writes the finishing places of its
+ * own seats into a flat array, and only once every table is done the round
+ * is rated as one Elo and Glicko rating period:
+ * - Every table adds up, for its own players, the expected and actual
+ *   scores against each opponent at the table. A player sits at one table
+ *   per round, so tables never write to the same slot and need no lock.
+ * - Then every player applies its sums, in parallel over the players.
+ * All of it uses the ratings from before the round, so the order in which
+ * tables finish changes nothing.
+ *
+ * A game between more than two players counts as a match against every
+ * other player at the table: the winner beats everybody, the others are
+ * ranked by the cards left in their hands, and the matches of a game count
+ * 1 / (players - 1) each so that a game weighs as much at any table size.
+ *
+ * Functionality:
+ * - `play_round`: Plays and rates the tables of a round.
+ * - `get_games_played`: Gets the number of games played so far.
+ */
+class Tournament {
+public:
+
+    Tournament(PlayerRegistry& registry, WorkStealingPool& pool, uint64_t seed) : registry(registry), pool(pool), seed(seed), rounds(0), games_played(0), workers(pool.get_threads()) {
+    }
+
+    void play_round(const Round& round) {
+        uint32_t n = registry.size();
+        int tables = round.tables();
+        places.assign(round.players.size(), 0);
+        v_sum.assign(n, 0);
+        delta_sum.assign(n, 0);
+        elo_sum.assign(n, 0);
+
+        uint32_t tasks = (tables + TABLES_PER_TASK - 1) / TABLES_PER_TASK;
+        uint64_t round_seed = game_seed(seed, rounds);
+        pool.run(tasks, [&](int w, uint32_t task) {
+            int last = std::min(tables, (int) (task + 1) * TABLES_PER_TASK);
+            for (int t = task * TABLES_PER_TASK; t < last; t++) {
+                play_table(workers[w], round, t, game_seed(round_seed, t));
+                accumulate(round, t);
+            }
+        });
+
+        // one rating period for everybody, every deviation grows first
+        pool.run((n + 4095) / 4096, [&](int, uint32_t task) {
+            uint32_t last = std::min(n, (task + 1) * 4096);
+            for (uint32_t id = task * 4096; id < last; id++) {
+                apply(id);
+            }
+        });
+        for (int t = 0; t < tables; t++) {
+            for (uint32_t k = round.starts[t]; k < round.starts[t + 1]; k++) {
+                uint32_t id = round.players[k];
+                registry.games[id]++;
+                registry.last_table[id] = t;
+                if (places[k] == 0) {
+                    registry.wins[id]++;
+                    registry.score[id]++;
+                }
+            }
+        }
+        for (uint32_t id : round.byes) {
+            registry.score[id]++;
+            registry.last_table[id] = -1;
+        }
+        games_played += tables;
+        rounds++;
+    }
+
+    long long get_games_played() const {
+        return games_played;
+    }
+
+private:
+
+    struct alignas(64) Worker {
+        GameEngine engine;
+        Rng noise;
+        std::vector<Move> moves;
+    };
+
+    PlayerRegistry& registry;
+    WorkStealingPool& pool;
+    uint64_t seed;
+    int rounds;
+    long long games_played;
+    std::vector<Worker> workers;
+    std::vector<uint8_t> places; // finishing place of every seat of the round, 0 is the winner
+    std::vector<double> v_sum; // Glicko: sum of g^2 E (1 - E) over the round
+    std::vector<double> delta_sum; // Glicko: sum of g (s - E)
+    std::vector<double> elo_sum; // Elo: sum of s - E
+
+    static double glicko_g(double deviation) {
+        const double q = std::log(10.0) / 400;
+        return 1 / std::sqrt(1 + 3 * q * q * deviation * deviation / (M_PI * M_PI));
+    }
+
+    void play_table(Worker& worker, const Round& round, int t, uint64_t table_seed) {
+        GameEngine& engine = worker.engine;
+        const uint32_t* ids = &round.players[round.starts[t]];
+        int seats = round.seats(t);
+        engine.new_game(seats, table_seed);
+        worker.noise.seed(table_seed ^ 0x9e3779b97f4a7c15ULL);
+        while (!engine.is_over() && engine.get_turn_count() < MAX_TURNS) {
+            float bot_skill = registry.skill[ids[engine.get_turn()]];
+            if (worker.noise.bounded(1 << 24) < bot_skill * (1 << 24)) {
+                engine.step(simple_policy(engine));
+            } else {
+                engine.legal_moves(worker.moves);
+                engine.step(worker.moves[worker.noise.bounded(worker.moves.size())]);
+            }
+        }
+        // the winner first, then by the cards left in hand, equal hands share a place
+        uint8_t* place = &places[round.starts[t]];
+        for (int s = 0; s < seats; s++) {
+            int cards = engine.get_player(s).get_size();
+            int better = 0;
+            for (int o = 0; o < seats; o++) {
+                int other = engine.get_player(o).get_size();
+                better += o != s && (o == engine.get_winner() || (s != engine.get_winner() && other < cards));
+            }
+            place[s] = better;
+        }
+    }
+
+    // Function to add up the matches of table t for its own players
+
+    void accumulate(const Round& round, int t) {
+        uint32_t start = round.starts[t];
+        int seats = round.seats(t);
+        double weight = 1.0 / (seats - 1);
+        for (int s = 0; s < seats; s++) {
+            uint32_t id = round.players[start + s];
+            for (int o = 0; o < seats; o++) {
+                if (o == s) {
+                    continue;
+                }
+                uint32_t other = round.players[start + o];
+                double result = places[start + s] < places[start + o] ? 1 : places[start + s] == places[start + o] ? 0.5 : 0;
+                double g = glicko_g(registry.deviation[other]);
+                double expected = 1 / (1 + std::pow(10.0, -g * (registry.rating[id] - registry.rating[other]) / 400));
+                v_sum[id] += weight * g * g * expected * (1 - expected);
+                delta_sum[id] += weight * g * (result - expected);
+                double elo_expected = 1 / (1 + std::pow(10.0, (registry.elo[other] - registry.elo[id]) / 400));
+                elo_sum[id] += weight * (result - elo_expected);
+            }
+        }
+    }
+
+    void apply(uint32_t id) {
+        const double q = std::log(10.0) / 400;
+        double deviation = std::min(std::sqrt(registry.deviation[id] * registry.deviation[id] + RD_GROWTH * RD_GROWTH), RD_START);
+        if (v_sum[id] > 0) {
+            double precision = 1 / (deviation * deviation) + q * q * v_sum[id];
+            registry.rating[id] += q / precision * delta_sum[id];
+            deviation = std::sqrt(1 / precision);
+            registry.elo[id] += ELO_K * elo_sum[id];
+        }
+        registry.deviation[id] = deviation;
+    }
+};
+
+#endif /* TOURNAMENT_H */
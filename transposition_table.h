@@ -0,0 +1,177 @@
+/*
+ * File:   transposition_table.h
+ *
+ * Fixed-size hash table of search results that any number of threads read
+ * and write at once without locks.
+ */
+
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#define TT_BUCKET_ENTRIES 4
+#define TT_PROVEN_DEPTH 255 // depth of a result that no search horizon cut short
+
+enum TT_BOUND {
+    tt_none, tt_exact, tt_lower, tt_upper
+};
+
+/**
+ * Struct: TTData
+ * Description:
+ * One stored search result, packed into 64 bits: the value (a float), the
+ * depth it was searched to, what kind of bound it is, the best move found and
+ * the search generation that wrote it.
+ */
+struct TTData {
+    float value;
+    int depth;
+    TT_BOUND bound;
+    int move;
+    int generation;
+
+    uint64_t pack() const {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof (bits));
+        return bits | (uint64_t) depth << 32 | (uint64_t) bound << 40 | (uint64_t) (move & 1023) << 42 | (uint64_t) (generation & 255) << 52;
+    }
+
+    static TTData unpack(uint64_t data) {
+        TTData out;
+        uint32_t bits = (uint32_t) data;
+        std::memcpy(&out.value, &bits, sizeof (bits));
+        out.depth = (data >> 32) & 255;
+        out.bound = static_cast<TT_BOUND> ((data >> 40) & 3);
+        out.move = (data >> 42) & 1023;
+        out.generation = (data >> 52) & 255;
+        return out;
+    }
+};
+
+/**
+ * Class: TranspositionTable
+ * Description:
+ * Buckets of TT_BUCKET_ENTRIES entries, one cache line each, picked by the
+ * low bits of the key. An entry is two relaxed atomic words: the packed data
+ * and the key XORed with that data. A reader that sees the halves of two
+ * different writes gets a key that does not match and treats it as a miss, so
+ * torn entries are never used and no lock or fence is needed.
+ *
+ * Replacement: a result for a key already in the bucket overwrites it unless
+ * it is shallower and not exact. Otherwise the entry that is least worth
+ * keeping goes: empty entries first, then the shallowest, where every search
+ * generation an entry has survived counts as losing some depth.
+ *
+ * Functionality:
+ * - `probe`: Looks a key up.
+ * - `store`: Saves a result for a key.
+ * - `new_search`: Starts a new generation, ageing everything stored so far.
+ * - `clear`: Empties the table.
+ */
+class TranspositionTable {
+public:
+
+    // Function to make a table of about megabytes MB, rounded down to a power of two buckets
+
+    explicit TranspositionTable(size_t megabytes) : generation(0) {
+        size_t buckets = 1;
+        while (buckets * 2 * sizeof (Bucket) <= megabytes * 1024 * 1024) {
+            buckets *= 2;
+        }
+        table = std::vector<Bucket>(buckets);
+        mask = buckets - 1;
+    }
+
+    bool probe(uint64_t key, TTData& out) const {
+        const Bucket& bucket = table[key & mask];
+        for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+            uint64_t data = bucket.entries[i].data.load(std::memory_order_relaxed);
+            uint64_t check = bucket.entries[i].check.load(std::memory_order_relaxed);
+            if ((check ^ data) == key && data != 0) {
+                out = TTData::unpack(data);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void store(uint64_t key, float value, int depth, TT_BOUND bound, int move) {
+        Bucket& bucket = table[key & mask];
+        int victim = 0;
+        int victim_worth = 1 << 30;
+        for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+            uint64_t data = bucket.entries[i].data.load(std::memory_order_relaxed);
+            uint64_t check = bucket.entries[i].check.load(std::memory_order_relaxed);
+            if (data == 0) {
+                if (victim_worth > -1) {
+                    victim = i;
+                    victim_worth = -1;
+                }
+                continue;
+            }
+            TTData old = TTData::unpack(data);
+            if ((check ^ data) == key) {
+                if (depth < old.depth && bound != tt_exact) {
+                    return;
+                }
+                victim = i;
+                break;
+            }
+            int worth = old.depth - 8 * ((generation - old.generation) & 255);
+            if (worth < victim_worth) {
+                victim = i;
+                victim_worth = worth;
+            }
+        }
+
+        TTData entry = {value, depth, bound, move, generation};
+        uint64_t data = entry.pack();
+        bucket.entries[victim].data.store(data, std::memory_order_relaxed);
+        bucket.entries[victim].check.store(key ^ data, std::memory_order_relaxed);
+    }
+
+    void new_search() {
+        generation = (generation + 1) & 255;
+    }
+
+    void clear() {
+        for (Bucket& bucket : table) {
+            for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+                bucket.entries[i].data.store(0, std::memory_order_relaxed);
+                bucket.entries[i].check.store(0, std::memory_order_relaxed);
+            }
+        }
+        generation = 0;
+    }
+
+    size_t get_entries() const {
+        return table.size() * TT_BUCKET_ENTRIES;
+    }
+
+private:
+
+    struct Entry {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;
+
+        Entry() : check(0), data(0) {
+        }
+
+        Entry(const Entry&) : check(0), data(0) {
+        }
+    };
+
+    struct alignas(64) Bucket {
+        Entry entries[TT_BUCKET_ENTRIES];
+    };
+
+    std::vector<Bucket> table;
+    uint64_t mask;
+    int generation;
+};
+
+#endif /* TRANSPOSITION_TABLE_H */